@@ -0,0 +1,73 @@
+#ifndef AIRLINES_H
+#define AIRLINES_H
+
+// Airline names published by the ATC process (q1.c writes ATCairlines), one
+// per line in id order. avn.c and stipepay.c see only airline ids; they load
+// the file on first use and re-read it on a miss only once it has changed,
+// so an unknown id costs a stat() rather than a reload. Lookups copy the
+// name out under a read lock, so avn's workers can resolve names while one
+// of them reloads the table.
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define AIRLINE_REGISTRY_FILE "ATCairlines"
+#define MAX_AIRLINES 64
+#define AIRLINE_NAME_SIZE 128
+
+static char airlineNames[MAX_AIRLINES][AIRLINE_NAME_SIZE];
+static int airlineNameCount = 0;
+static bool airlineNamesLoaded = false;
+static struct timespec airlineNamesMtime;
+static off_t airlineNamesSize;
+static pthread_rwlock_t airlineNamesLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Re-reads the registry if the file differs from the copy last loaded;
+// caller holds airlineNamesLock for writing.
+static void loadAirlineNames() {
+    struct stat st;
+    if (stat(AIRLINE_REGISTRY_FILE, &st) < 0) return;
+    if (airlineNamesLoaded && st.st_size == airlineNamesSize && st.st_mtim.tv_sec == airlineNamesMtime.tv_sec &&
+        st.st_mtim.tv_nsec == airlineNamesMtime.tv_nsec) return;
+    FILE* file = fopen(AIRLINE_REGISTRY_FILE, "r");
+    if (!file) return;
+    char line[AIRLINE_NAME_SIZE];
+    int count = 0;
+    while (count < MAX_AIRLINES && fgets(line, sizeof(line), file)) {
+        size_t length = strcspn(line, "\r\n");
+        // A name too long for the table is cut; the rest of its line is skipped.
+        if (line[length] == '\0') {
+            int c;
+            while ((c = fgetc(file)) != EOF && c != '\n') {
+            }
+        }
+        line[length] = '\0';
+        memcpy(airlineNames[count++], line, length + 1);
+    }
+    fclose(file);
+    airlineNameCount = count;
+    airlineNamesLoaded = true;
+    airlineNamesMtime = st.st_mtim;
+    airlineNamesSize = st.st_size;
+}
+
+// Copies the name of airlineId into name and returns it. Inline so q1.c,
+// which owns the registry and never reads it back, can share the header.
+static inline const char* getAirlineName(int airlineId, char* name, size_t size) {
+    pthread_rwlock_rdlock(&airlineNamesLock);
+    bool known = airlineNamesLoaded && airlineId >= 0 && airlineId < airlineNameCount;
+    if (known) snprintf(name, size, "%s", airlineNames[airlineId]);
+    pthread_rwlock_unlock(&airlineNamesLock);
+    if (known) return name;
+    pthread_rwlock_wrlock(&airlineNamesLock);
+    if (airlineId >= 0) loadAirlineNames();
+    known = airlineId >= 0 && airlineId < airlineNameCount;
+    snprintf(name, size, "%s", known ? airlineNames[airlineId] : "Unknown Airline");
+    pthread_rwlock_unlock(&airlineNamesLock);
+    return name;
+}
+
+#endif
@@ -12,16 +12,27 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/wait.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <SFML/Graphics.h>
+#include "airlines.h"
 
 typedef enum { COMMERCIAL, CARGO, EMERGENCY, VIP } FlightType;
 typedef enum { HOLDING, APPROACH, LANDING, TAXI, AT_GATE, TAKEOFF_ROLL, CLIMB, CRUISE } FlightPhase;
 typedef enum { INACTIVE, ACTIVE } AVNStatus;
-typedef enum { RWY_A, RWY_B, RWY_C, NO_RUNWAY } Runway;
+typedef int Runway;   // index into the ATC runway table
+#define NO_RUNWAY -1
 typedef enum { NORTH, SOUTH, EAST, WEST, UNDEFINED_DIR } Direction;
 
 typedef struct {
-    char name[30];
+    uint64_t s[4];
+} RngStream;
+
+typedef struct {
     char id[20];
     int airlineId;
     FlightType type;
@@ -47,14 +58,18 @@ typedef struct {
     float targetY;
     float velocityX;
     float velocityY;
+    float altitudeCarry;      // climb below one foot not yet in altitude
     bool isVIP;
     time_t lastReportedViolation;
+    RngStream rng;
     sfSprite* sprite;
 } Flight;
 
 
 typedef struct {
 Flight flight;
+uint64_t traceId;
+uint64_t detectedNs;
 } AVNData;
 
 typedef struct {
@@ -75,9 +90,17 @@ typedef struct {
     int amount;
     FlightType airlinetype;
     int airlineId;
-    char airlineName[30];
+    uint64_t traceId;
+    uint64_t detectedNs;
+    uint64_t issuedNs;
+    uint64_t ledgerNs;
 } TicketData;
-TicketData td;
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
 int getMinAllowedSpeed(FlightPhase phase) {
     if (phase == HOLDING) return 400;
@@ -147,120 +170,419 @@ PositionRange getSafePositionRangeForPhase(FlightPhase phase) {
     }
 }
 
-int main() {
+// AVN issuance pool. The reader numbers every notice from avnSequence as
+// soon as it has been read in full, so ids are monotonic and gap-free. Workers
+// format and price notices in parallel inside a bounded window, and the
+// emitter drains the window strictly in id order, so the report log and the
+// tickets forwarded to stipepay look exactly as if one thread produced them.
+#define MAX_AVN_WORKERS 64
+#define AVN_WINDOW 256
+#define AVN_REPORT_SIZE 1024
+
+typedef enum { JOB_EMPTY, JOB_QUEUED, JOB_DONE } AVNJobState;
+
+typedef struct {
+    int id;
+    AVNJobState state;
+    AVNData notice;
+    char source[32];
+    TicketData ticket;
+    char console[AVN_REPORT_SIZE];
+    int consoleLen;
+    char log[AVN_REPORT_SIZE];
+    int logLen;
+} AVNJob;
+
+#define REPORT_CONSOLE 1
+#define REPORT_LOG 2
+
+AVNJob avnWindow[AVN_WINDOW];
+atomic_int avnSequence = 1;
+int avnNextEmit = 1;
+int avnQueue[AVN_WINDOW];   // ids waiting for a worker
+int avnQueueHead = 0;
+int avnQueueCount = 0;
+pthread_mutex_t avnLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t avnWorkReady = PTHREAD_COND_INITIALIZER;
+pthread_cond_t avnJobDone = PTHREAD_COND_INITIALIZER;
+pthread_cond_t avnSlotFree = PTHREAD_COND_INITIALIZER;
+FILE* avnLogFile = NULL;
+const char* avnToSpFifo = "AVNtoSP";
+
+void reportf(AVNJob* job, int targets, const char* fmt, ...) {
+    va_list args;
+    if (targets & REPORT_CONSOLE) {
+        va_start(args, fmt);
+        int n = vsnprintf(job->console + job->consoleLen, AVN_REPORT_SIZE - job->consoleLen, fmt, args);
+        va_end(args);
+        if (n > 0) job->consoleLen += (n < AVN_REPORT_SIZE - job->consoleLen) ? n : AVN_REPORT_SIZE - 1 - job->consoleLen;
+    }
+    if (targets & REPORT_LOG) {
+        va_start(args, fmt);
+        int n = vsnprintf(job->log + job->logLen, AVN_REPORT_SIZE - job->logLen, fmt, args);
+        va_end(args);
+        if (n > 0) job->logLen += (n < AVN_REPORT_SIZE - job->logLen) ? n : AVN_REPORT_SIZE - 1 - job->logLen;
+    }
+}
+
+// Everything that does not depend on other notices: the report text and the
+// ticket. Runs on a worker without holding avnLock.
+void processNotice(AVNJob* job) {
+    const int both = REPORT_CONSOLE | REPORT_LOG;
+    AVNData* a = &job->notice;
+    job->consoleLen = 0;
+    job->logLen = 0;
+
+    reportf(job, both, "-----AVN is Generating-----\n");
+    const char* flightType = getFlightTypeString(a->flight.type);
+    char airlineName[AIRLINE_NAME_SIZE];
+    getAirlineName(a->flight.airlineId, airlineName, sizeof(airlineName));
+    reportf(job, both, "AVN ID: %d, Airline Name: %s, Flight Number:%d, Aircraft Type:%s\n",
+            job->id, airlineName, a->flight.airlineId, flightType);
+    reportf(job, both, "Source: %s\n", job->source);
+
+    int minSpeed = getMinAllowedSpeed(a->flight.phase);
+    int maxSpeed = getMaxAllowedSpeed(a->flight.phase);
+    int minAltitude = getSafeAltitudeForPhase(a->flight.phase);
+    int maxAltitude = getMaxAllowedAltitude(a->flight.phase);
+    PositionRange safePos = getSafePositionRangeForPhase(a->flight.phase);
+
+    reportf(job, both, "Permissible Speed: %d - %d | Recorded Speed: %d\n", minSpeed, maxSpeed, a->flight.speed);
+    reportf(job, both, "Permissible Altitude: %d - %d | Current Altitude: %d\n", minAltitude, maxAltitude, a->flight.altitude);
+    reportf(job, both, "Permissible Position Range: %d - %d | Current Position: %d\n", safePos.min, safePos.max, a->flight.position);
+
+    struct tm timeInfo;
+    char avnTimeStr[64];
+    localtime_r(&a->flight.lastReportedViolation, &timeInfo);
+    strftime(avnTimeStr, sizeof(avnTimeStr), "%Y-%m-%d %H:%M:%S", &timeInfo);
+
+    time_t dueDateTime = a->flight.lastReportedViolation + 3 * 24 * 60 * 60;
+    char dueDateStr[64];
+    localtime_r(&dueDateTime, &timeInfo);
+    strftime(dueDateStr, sizeof(dueDateStr), "%Y-%m-%d %H:%M:%S", &timeInfo);
+
+    int baseChallan = 0;
+    if (a->flight.type == COMMERCIAL) baseChallan = 500000;
+    else if (a->flight.type == CARGO) baseChallan = 700000;
+
+    float adminFee = baseChallan * 0.15f;
+    float totalFine = baseChallan + adminFee;
+
+    reportf(job, both, "AVN Time Issued: %s\n", avnTimeStr);
+    reportf(job, both, "Due Date: %s\n", dueDateStr);
+
+    TicketData* td = &job->ticket;
+    td->id = job->id;
+    td->status = 0;
+    td->amount = totalFine;
+    td->airlinetype = a->flight.type;
+    td->airlineId = a->flight.airlineId;
+    td->traceId = a->traceId;
+    td->detectedNs = a->detectedNs;
+    td->issuedNs = monotonicNs();
+    td->ledgerNs = 0;
+    reportf(job, REPORT_LOG, "Trace ID: %016llx\n", (unsigned long long)td->traceId);
+    if (baseChallan > 0) {
+        reportf(job, both, "Base Challan: RS.%d\n", baseChallan);
+        reportf(job, both, "Admin Fee (15%%): RS.%.2f\n", adminFee);
+        reportf(job, both, "Total Fine: RS.%.2f\n", totalFine);
+        reportf(job, both, "Status: Unpaid\n");
+    } else {
+        reportf(job, both, "No challan applicable for this flight type.\n");
+    }
+    reportf(job, REPORT_LOG, "\n");
+}
+
+// Called by the reader once a notice has been read in full. Blocks while the
+// window is full so a violation storm cannot outrun the emitter unboundedly.
+void submitNotice(const AVNData* notice, const char* source) {
+    int id = atomic_fetch_add(&avnSequence, 1);
+    AVNJob* job = &avnWindow[id % AVN_WINDOW];
+
+    pthread_mutex_lock(&avnLock);
+    while (id - avnNextEmit >= AVN_WINDOW)
+        pthread_cond_wait(&avnSlotFree, &avnLock);
+    job->id = id;
+    job->notice = *notice;
+    snprintf(job->source, sizeof(job->source), "%s", source);
+    job->state = JOB_QUEUED;
+    avnQueue[(avnQueueHead + avnQueueCount) % AVN_WINDOW] = id;
+    avnQueueCount++;
+    pthread_cond_signal(&avnWorkReady);
+    pthread_mutex_unlock(&avnLock);
+}
+
+void* avnWorker(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&avnLock);
+        while (avnQueueCount == 0)
+            pthread_cond_wait(&avnWorkReady, &avnLock);
+        int id = avnQueue[avnQueueHead];
+        avnQueueHead = (avnQueueHead + 1) % AVN_WINDOW;
+        avnQueueCount--;
+        pthread_mutex_unlock(&avnLock);
+
+        AVNJob* job = &avnWindow[id % AVN_WINDOW];
+        processNotice(job);
+
+        pthread_mutex_lock(&avnLock);
+        job->state = JOB_DONE;
+        if (id == avnNextEmit) pthread_cond_signal(&avnJobDone);
+        pthread_mutex_unlock(&avnLock);
+    }
+    return NULL;
+}
+
+void forwardTicket(const TicketData* td) {
+    int fd1 = open(avnToSpFifo, O_WRONLY);
+    if (fd1 < 0) {
+        perror("open failed");
+        exit(EXIT_FAILURE);
+    }
+    write(fd1, td, sizeof(TicketData));
+    close(fd1);
+}
+
+// Reorder stage: the only thread that touches stdout, the report log and the
+// AVNtoSP FIFO, always in AVN id order.
+void* avnEmitter(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&avnLock);
+        AVNJob* job = &avnWindow[avnNextEmit % AVN_WINDOW];
+        while (job->state != JOB_DONE || job->id != avnNextEmit)
+            pthread_cond_wait(&avnJobDone, &avnLock);
+        pthread_mutex_unlock(&avnLock);
+
+        fwrite(job->console, 1, job->consoleLen, stdout);
+        fflush(stdout);
+        fwrite(job->log, 1, job->logLen, avnLogFile);
+        fflush(avnLogFile);
+        forwardTicket(&job->ticket);
+
+        pthread_mutex_lock(&avnLock);
+        job->state = JOB_EMPTY;
+        avnNextEmit++;
+        pthread_cond_broadcast(&avnSlotFree);
+        pthread_mutex_unlock(&avnLock);
+    }
+    return NULL;
+}
+
+// Producers. The legacy ATCtoAVN FIFO is producer 0; every ATC instance that
+// connects to the SOCK_SEQPACKET socket gets its own slot and names itself
+// with an AVNHello. Seqpacket keeps each AVNData one message, so concurrent
+// writers cannot interleave, and the slot tells us who sent it.
+#define AVN_SOCKET_PATH "ATCtoAVN.sock"
+#define AVN_HELLO_MAGIC "AVNHELO"
+#define MAX_AVN_PRODUCERS 32
+#define AVN_PRODUCER_QUEUE 64
+
+typedef struct {
+    char magic[8];
+    char sector[32];
+    int pid;
+} AVNHello;
+
+typedef struct {
+    int fd;
+    bool open;
+    char name[32];
+    AVNData queue[AVN_PRODUCER_QUEUE];
+    int head;
+    int count;
+    long received;
+    long issued;
+    long malformed;
+} AVNProducer;
+
+AVNProducer producers[MAX_AVN_PRODUCERS];
+int producerCount = 0;
+
+AVNProducer* addProducer(int fd, const char* name) {
+    for (int p = 0; p < MAX_AVN_PRODUCERS; p++) {
+        AVNProducer* producer = &producers[p];
+        if (producer->open || producer->count > 0) continue;
+        memset(producer, 0, sizeof(*producer));
+        producer->fd = fd;
+        producer->open = true;
+        snprintf(producer->name, sizeof(producer->name), "%s", name);
+        if (p >= producerCount) producerCount = p + 1;
+        return producer;
+    }
+    return NULL;
+}
+
+void closeProducer(AVNProducer* producer) {
+    close(producer->fd);
+    producer->open = false;
+    printf("[AVN] %s disconnected after %ld notices (%ld malformed)\n",
+           producer->name, producer->received, producer->malformed);
+}
+
+void queueNotice(AVNProducer* producer, const AVNData* notice) {
+    producer->queue[(producer->head + producer->count) % AVN_PRODUCER_QUEUE] = *notice;
+    producer->count++;
+    producer->received++;
+}
+
+// Drains whatever the producer has ready, up to its queue space. A full queue
+// leaves the rest in the kernel buffer, which pushes back on that producer only.
+void readProducer(AVNProducer* producer, bool isFifo) {
+    while (producer->count < AVN_PRODUCER_QUEUE) {
+        union { AVNData notice; AVNHello hello; } msg;
+        ssize_t n = isFifo ? read(producer->fd, &msg, sizeof(AVNData))
+                           : recv(producer->fd, &msg, sizeof(msg), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) closeProducer(producer);
+            return;
+        }
+        if (n == 0) {
+            if (!isFifo) closeProducer(producer);
+            return;
+        }
+        if (n == sizeof(AVNData)) {
+            queueNotice(producer, &msg.notice);
+        } else if (n == sizeof(AVNHello) && strncmp(msg.hello.magic, AVN_HELLO_MAGIC, sizeof(msg.hello.magic)) == 0) {
+            msg.hello.sector[sizeof(msg.hello.sector) - 1] = '\0';
+            snprintf(producer->name, sizeof(producer->name), "%s", msg.hello.sector);
+            printf("[AVN] Producer %ld registered as %s\n", (long)msg.hello.pid, producer->name);
+        } else {
+            producer->malformed++;
+        }
+    }
+}
+
+// One round of round-robin: every producer with queued notices submits at
+// most one, so a noisy sector cannot starve the others.
+bool dispatchRound() {
+    bool any = false;
+    for (int p = 0; p < producerCount; p++) {
+        AVNProducer* producer = &producers[p];
+        if (producer->count == 0) continue;
+        submitNotice(&producer->queue[producer->head], producer->name);
+        producer->head = (producer->head + 1) % AVN_PRODUCER_QUEUE;
+        producer->count--;
+        producer->issued++;
+        any = true;
+    }
+    return any;
+}
+
+int openAVNSocket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("socket failed");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, MAX_AVN_PRODUCERS) < 0) {
+        perror("bind failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
     const char* fifo_path = "ATCtoAVN";
+    const char* socketPath = AVN_SOCKET_PATH;
+    int workers = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--workers N] [--socket PATH]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > MAX_AVN_WORKERS) workers = MAX_AVN_WORKERS;
 
     if (mkfifo(fifo_path, 0666) < 0 && errno != EEXIST) {
         perror("mkfifo failed");
         exit(EXIT_FAILURE);
     }
+    if (mkfifo(avnToSpFifo, 0666) < 0 && errno != EEXIST) {
+        perror("mkfifo1 failed");
+        exit(EXIT_FAILURE);
+    }
 
-    int fd = open(fifo_path, O_RDONLY);
-    if (fd < 0) {
+    avnLogFile = fopen("avn_report.log", "a");
+    if (!avnLogFile) {
+        perror("Failed to open log file");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t emitter;
+    pthread_t pool[MAX_AVN_WORKERS];
+    pthread_create(&emitter, NULL, avnEmitter, NULL);
+    for (int w = 0; w < workers; w++)
+        pthread_create(&pool[w], NULL, avnWorker, NULL);
+
+    // Holding a write end ourselves keeps the FIFO from reporting EOF between
+    // ATC writers, so poll() never spins on a hung-up pipe.
+    int fd = open(fifo_path, O_RDONLY | O_NONBLOCK);
+    int keepalive = open(fifo_path, O_WRONLY);
+    if (fd < 0 || keepalive < 0) {
         perror("open failed");
         exit(EXIT_FAILURE);
     }
+    addProducer(fd, "ATCtoAVN");
+    int listenFd = openAVNSocket(socketPath);
 
-    AVNData a;
-    int i = 1;
+    struct pollfd fds[MAX_AVN_PRODUCERS + 1];
+    int owners[MAX_AVN_PRODUCERS + 1];
     while (1) {
-        ssize_t bytesRead = read(fd, &a, sizeof(AVNData));
-        if (bytesRead == sizeof(AVNData)) {
-            FILE* logFile = fopen("avn_report.log", "a");
-            if (!logFile) {
-                perror("Failed to open log file");
-                exit(EXIT_FAILURE);
-            }
-            printf("-----AVN is Generating-----\n");
-            fprintf(logFile, "-----AVN is Generating-----\n");
-            const char* flightType = getFlightTypeString(a.flight.type);
-            td.id = i;
-            printf("AVN ID: %d, Airline Name: %s, Flight Number:%d, Aircraft Type:%s\n", i, a.flight.name,          a.flight.airlineId, flightType);
-fprintf(logFile, "AVN ID: %d, Airline Name: %s, Flight Number:%d, Aircraft Type:%s\n", i, a.flight.name, a.flight.airlineId, flightType);
-i++;
-            int minSpeed = getMinAllowedSpeed(a.flight.phase);
-            int maxSpeed = getMaxAllowedSpeed(a.flight.phase);
-            int minAltitude = getSafeAltitudeForPhase(a.flight.phase);
-            int maxAltitude = getMaxAllowedAltitude(a.flight.phase);
-            PositionRange safePos = getSafePositionRangeForPhase(a.flight.phase);
-
-            printf("Permissible Speed: %d - %d | Recorded Speed: %d\n", minSpeed, maxSpeed, a.flight.speed);
-            printf("Permissible Altitude: %d - %d | Current Altitude: %d\n", minAltitude, maxAltitude, a.flight.altitude);
-            printf("Permissible Position Range: %d - %d | Current Position: %d\n", safePos.min, safePos.max, a.flight.position);
-
-            fprintf(logFile, "Permissible Speed: %d - %d | Recorded Speed: %d\n", minSpeed, maxSpeed, a.flight.speed);
-            fprintf(logFile, "Permissible Altitude: %d - %d | Current Altitude: %d\n", minAltitude, maxAltitude, a.flight.altitude);
-            fprintf(logFile, "Permissible Position Range: %d - %d | Current Position: %d\n", safePos.min, safePos.max, a.flight.position);
-
-           char avnTimeStr[64];
-          struct tm* avnTimeInfo = localtime(&a.flight.lastReportedViolation);
-          strftime(avnTimeStr, sizeof(avnTimeStr), "%Y-%m-%d %H:%M:%S", avnTimeInfo);
-
-          time_t dueDateTime = a.flight.lastReportedViolation + 3 * 24 * 60 * 60;
-          char dueDateStr[64];
-          struct tm* dueDateInfo = localtime(&dueDateTime);
-          strftime(dueDateStr, sizeof(dueDateStr), "%Y-%m-%d %H:%M:%S", dueDateInfo);
-
-          int baseChallan = 0;
-          if (a.flight.type == COMMERCIAL) baseChallan = 500000;
-          else if (a.flight.type == CARGO) baseChallan = 700000;
-
-          float adminFee = baseChallan * 0.15f;
-          float totalFine = baseChallan + adminFee;
-
-          printf("AVN Time Issued: %s\n", avnTimeStr);
-          fprintf(logFile, "AVN Time Issued: %s\n", avnTimeStr);
-          printf("Due Date: %s\n", dueDateStr);
-          fprintf(logFile, "Due Date: %s\n", dueDateStr);
-          td.status = 0;
-          td.amount = totalFine;
-          td.airlinetype = a.flight.type;
-          strcpy(td.airlineName, a.flight.name);
-          td.airlineId = a.flight.airlineId;
-          if (baseChallan > 0) {
-              printf("Base Challan: RS.%d\n", baseChallan);
-              printf("Admin Fee (15%%): RS.%.2f\n", adminFee);
-              printf("Total Fine: RS.%.2f\n", totalFine);
-
-              fprintf(logFile, "Base Challan: RS.%d\n", baseChallan);
-              fprintf(logFile, "Admin Fee (15%%): RS.%.2f\n", adminFee);
-              fprintf(logFile, "Total Fine: RS.%.2f\n", totalFine);
-              
-              printf("Status: Unpaid\n");
-              fprintf(logFile, "Status: Unpaid\n");
-          } else {
-              printf("No challan applicable for this flight type.\n");
-              fprintf(logFile, "No challan applicable for this flight type.\n");
-          }
-            
-            fprintf(logFile, "\n");  
-            fclose(logFile);         
-            char fifo_path1[20] = "AVNtoSP";
-            
-            if (mkfifo(fifo_path1, 0666) < 0 && errno != EEXIST) {
-            perror("mkfifo1 failed");
-            exit(EXIT_FAILURE);
-            }
-            int fd1 = open(fifo_path1, O_WRONLY);
-            if (fd1 < 0) {
-                perror("open failed");
-                exit(EXIT_FAILURE);
-            }
-            
-            write(fd1, &td, sizeof(TicketData));
-            close(fd1);
-            
-            
-        } else if (bytesRead == 0) {
-            printf("\n");
-            close(fd);
-            fd = open(fifo_path, O_RDONLY);  
-        } else {
-            perror("read error");
+        int nfds = 0;
+        if (listenFd >= 0) {
+            fds[nfds] = (struct pollfd){ .fd = listenFd, .events = POLLIN };
+            owners[nfds++] = -1;
+        }
+        bool backlog = false;
+        for (int p = 0; p < producerCount; p++) {
+            if (producers[p].count > 0) backlog = true;
+            if (!producers[p].open || producers[p].count == AVN_PRODUCER_QUEUE) continue;
+            fds[nfds] = (struct pollfd){ .fd = producers[p].fd, .events = POLLIN };
+            owners[nfds++] = p;
+        }
+
+        if (poll(fds, nfds, backlog ? 0 : -1) < 0 && errno != EINTR) {
+            perror("poll error");
             break;
         }
+        for (int k = 0; k < nfds; k++) {
+            if (!fds[k].revents) continue;
+            if (owners[k] < 0) {
+                int conn = accept(listenFd, NULL, NULL);
+                if (conn < 0) continue;
+                char name[32];
+                snprintf(name, sizeof(name), "socket-%d", conn);
+                if (!addProducer(conn, name)) {
+                    fprintf(stderr, "[AVN] Too many producers, refusing connection\n");
+                    close(conn);
+                }
+            } else {
+                readProducer(&producers[owners[k]], owners[k] == 0);
+            }
+        }
+        dispatchRound();
     }
 
     close(fd);
+    close(keepalive);
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath);
+    }
     return 0;
 }
@@ -12,11 +12,22 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/wait.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <math.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <stddef.h>
 #include <SFML/Graphics.h>
+#include "airlines.h"
 
-#define MAX_FLIGHTS 20
-#define MAX_AIRLINES 6
-#define MAX_RUNWAYS 3
+#define MAX_FLIGHTS 65536
+#define MAX_RUNWAYS 16
+#define MAX_SECTORS MAX_RUNWAYS
 #define FUEL_THRESHOLD 20
 #define MAX_VIOLATION_MSG 512
 
@@ -28,18 +39,365 @@ int getCurrentSimulationTime() {
 }
 
 bool avnTriggered = false;
+bool avnOutputEnabled = true;
 pthread_mutex_t runwayLocks[MAX_RUNWAYS];
 pthread_mutex_t flightDataMutex;
 volatile bool flightDataReady = true; 
+// --sectors: each sector thread writes its flights under its own lock; code
+// that reads or edits the whole store takes all of them via lockFlightData().
+int sectorCount = 0;
+pthread_mutex_t sectorDataLocks[MAX_SECTORS];
 
 typedef enum { COMMERCIAL, CARGO, EMERGENCY, VIP } FlightType;
 typedef enum { HOLDING, APPROACH, LANDING, TAXI, AT_GATE, TAKEOFF_ROLL, CLIMB, CRUISE } FlightPhase;
 typedef enum { INACTIVE, ACTIVE } AVNStatus;
-typedef enum { RWY_A, RWY_B, RWY_C, NO_RUNWAY } Runway;
+typedef int Runway;   // index into runways[]
+#define NO_RUNWAY -1
 typedef enum { NORTH, SOUTH, EAST, WEST, UNDEFINED_DIR } Direction;
 
+// xoshiro256** generator. Every flight owns its own stream derived from the
+// scenario seed and its id, so draws never contend and runs are reproducible.
+typedef struct {
+    uint64_t s[4];
+} RngStream;
+
+uint64_t scenarioSeed;
+RngStream controlRng;
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rngSeed(RngStream* r, uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ splitmix64(&stream);
+    for (int i = 0; i < 4; i++) r->s[i] = splitmix64(&state);
+}
+
+static inline uint64_t rngNext(RngStream* r) {
+    uint64_t result = rotl64(r->s[1] * 5, 7) * 9;
+    uint64_t t = r->s[1] << 17;
+    r->s[2] ^= r->s[0];
+    r->s[3] ^= r->s[1];
+    r->s[1] ^= r->s[2];
+    r->s[0] ^= r->s[3];
+    r->s[2] ^= t;
+    r->s[3] = rotl64(r->s[3], 45);
+    return result;
+}
+
+// Uniform value in [0, n) using the multiply-shift reduction.
+static inline int rngBelow(RngStream* r, int n) {
+    return (int)(((rngNext(r) >> 32) * (uint64_t)n) >> 32);
+}
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+
+// FNV-1a over size bytes, continuing from h; start from FNV_OFFSET_BASIS.
+uint64_t fnvHash(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+uint64_t streamIdFor(const char* id) {
+    return fnvHash(FNV_OFFSET_BASIS, id, strlen(id));
+}
+
+// Asynchronous event log. Simulation threads append fixed binary records to
+// their own single-producer ring; a background sink formats them later, so
+// nothing on the tick path touches stdio or its lock.
+typedef enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_OFF } LogLevel;
+typedef enum { LOG_SINK_CONSOLE, LOG_SINK_FILE, LOG_SINK_BINARY } LogSink;
+
+typedef enum {
+    EV_FLIGHT_SCHEDULED,
+    EV_LIFECYCLE_START,
+    EV_LOW_FUEL,
+    EV_RUNWAY_ASSIGNED,
+    EV_RUNWAY_LOCKED,
+    EV_RUNWAY_RELEASED,
+    EV_PHASE_CHANGE,
+    EV_LIFECYCLE_DONE,
+    EV_FAULT,
+    EV_AVN_ACTIVATED,
+    EV_SPEED_VIOLATION,
+    EV_POSITION_VIOLATION,
+    EV_ALTITUDE_VIOLATION,
+    EV_GROUND_WAIT,
+    EV_CONFLICT_PREDICTED,
+    EV_ENVELOPE_PREDICTED
+} LogEvent;
+
+typedef struct {
+    uint64_t timestampNs;
+    uint16_t event;
+    uint16_t level;
+    int32_t args[4];
+    char flightId[20];
+} LogRecord;
+
+#define LOG_RING_SIZE 4096
+
+typedef struct LogBuffer {
+    LogRecord records[LOG_RING_SIZE];
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic bool inUse;
+    _Atomic uint64_t dropped;
+    struct LogBuffer* next;
+} LogBuffer;
+
+LogLevel logLevel = LOG_INFO;
+LogSink logSink = LOG_SINK_CONSOLE;
+LogBuffer* _Atomic logBuffers = NULL;
+__thread LogBuffer* threadLogBuffer = NULL;
+pthread_key_t logBufferKey;
+pthread_t logSinkThreadId;
+_Atomic bool logSinkRunning = false;
+
+void releaseLogBuffer(void* arg) {
+    LogBuffer* b = (LogBuffer*)arg;
+    atomic_store_explicit(&b->inUse, false, memory_order_release);
+}
+
+// Reuses a ring left behind by an exited thread, or registers a new one.
+LogBuffer* claimLogBuffer() {
+    for (LogBuffer* b = atomic_load(&logBuffers); b; b = b->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&b->inUse, &expected, true)) {
+            threadLogBuffer = b;
+            pthread_setspecific(logBufferKey, b);
+            return b;
+        }
+    }
+    LogBuffer* b = calloc(1, sizeof(LogBuffer));
+    if (!b) return NULL;
+    atomic_store(&b->inUse, true);
+    b->next = atomic_load(&logBuffers);
+    while (!atomic_compare_exchange_weak(&logBuffers, &b->next, b));
+    threadLogBuffer = b;
+    pthread_setspecific(logBufferKey, b);
+    return b;
+}
+
+void logEvent(LogLevel level, LogEvent event, const char* flightId, int a0, int a1, int a2, int a3) {
+    LogBuffer* b = threadLogBuffer ? threadLogBuffer : claimLogBuffer();
+    if (!b) return;
+    uint32_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&b->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&b->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    LogRecord* r = &b->records[head & (LOG_RING_SIZE - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    r->timestampNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    r->event = event;
+    r->level = level;
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    r->args[3] = a3;
+    strncpy(r->flightId, flightId ? flightId : "", sizeof(r->flightId) - 1);
+    r->flightId[sizeof(r->flightId) - 1] = '\0';
+    atomic_store_explicit(&b->head, head + 1, memory_order_release);
+}
+
+// Level check happens before any argument is evaluated into a record, so
+// filtered-out events cost one comparison.
+#define LOG_FLIGHT(level, event, f, a0, a1, a2, a3) \
+    do { if ((level) >= logLevel) logEvent((level), (event), (f)->id, (a0), (a1), (a2), (a3)); } while (0)
+
+// Log-linear latency histograms (HDR style): values below 16ns are exact,
+// above that every power of two is split into 16 sub-buckets, giving about
+// 6% relative precision over the full 64-bit range.
+#define HIST_SUB_BITS 4
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB_BUCKETS)
+
+typedef enum {
+    METRIC_TICK,
+    METRIC_RUNWAY_WAIT,
+    METRIC_FLIGHT_DATA_WAIT,
+    METRIC_FLIGHT_DATA_HOLD,
+    METRIC_AVN_FIFO_WRITE,
+    METRIC_RENDER_FRAME,
+    METRIC_SNAPSHOT_PAUSE,
+    METRIC_COUNT
+} MetricId;
+
+typedef enum {
+    COUNTER_TICKS,
+    COUNTER_AVN_NOTICES,
+    COUNTER_RUNWAY_GRANTS,
+    COUNTER_RUNWAY_PARKS,
+    COUNTER_FRAMES,
+    COUNTER_SNAPSHOTS,
+    COUNTER_GROUND_DELAYS,
+    COUNTER_SECTOR_HANDOFFS,
+    COUNTER_RADAR_REPORTS,
+    COUNTER_PREDICTED_CONFLICTS,
+    COUNTER_PREDICTED_ENVELOPE_EXITS,
+    COUNTER_COUNT
+} CounterId;
+
+typedef struct {
+    _Atomic uint64_t counts[HIST_BUCKETS];
+    _Atomic uint64_t total;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+} LatencyHistogram;
+
+const char* metricNames[METRIC_COUNT] = {
+    "tick", "runway_wait", "flight_data_wait", "flight_data_hold", "avn_fifo_write", "render_frame",
+    "snapshot_pause"
+};
+const char* counterNames[COUNTER_COUNT] = {
+    "ticks", "avn_notices", "runway_grants", "runway_parks", "frames", "snapshots", "ground_delays",
+    "sector_handoffs", "radar_reports", "predicted_conflicts", "predicted_envelope_exits"
+};
+
+LatencyHistogram metrics[METRIC_COUNT];
+_Atomic uint64_t counters[COUNTER_COUNT];
+const char* statsFilePath = NULL;
+_Atomic bool statsRunning = false;
+pthread_t statsThreadId;
+__thread uint64_t flightDataLockedAt;
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline int histogramBucket(uint64_t value) {
+    if (value < HIST_SUB_BUCKETS) return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS + sub;
+}
+
+// Upper bound of the values that land in a bucket.
+uint64_t histogramBucketValue(int bucket) {
+    if (bucket < HIST_SUB_BUCKETS) return bucket;
+    int msb = bucket / HIST_SUB_BUCKETS + HIST_SUB_BITS - 1;
+    uint64_t sub = bucket % HIST_SUB_BUCKETS;
+    uint64_t width = 1ULL << (msb - HIST_SUB_BITS);
+    return ((HIST_SUB_BUCKETS + sub) << (msb - HIST_SUB_BITS)) + width - 1;
+}
+
+static inline void recordLatency(MetricId id, uint64_t ns) {
+    LatencyHistogram* h = &metrics[id];
+    atomic_fetch_add_explicit(&h->counts[histogramBucket(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, ns, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (ns > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, ns,
+                                                               memory_order_relaxed, memory_order_relaxed));
+}
+
+static inline void countEvent(CounterId id) {
+    atomic_fetch_add_explicit(&counters[id], 1, memory_order_relaxed);
+}
+
+uint64_t histogramPercentile(LatencyHistogram* h, double percentile) {
+    uint64_t total = atomic_load_explicit(&h->total, memory_order_relaxed);
+    if (total == 0) return 0;
+    double rank = total * percentile / 100.0;
+    uint64_t target = (uint64_t)rank;
+    if (target < rank || target == 0) target++;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t value = histogramBucketValue(i);
+            uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+            return value < max ? value : max;
+        }
+    }
+    return atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+void lockFlightData() {
+    uint64_t start = monotonicNs();
+    pthread_mutex_lock(&flightDataMutex);
+    for (int i = 0; i < sectorCount; i++) pthread_mutex_lock(&sectorDataLocks[i]);
+    flightDataLockedAt = monotonicNs();
+    recordLatency(METRIC_FLIGHT_DATA_WAIT, flightDataLockedAt - start);
+}
+
+void unlockFlightData() {
+    uint64_t held = monotonicNs() - flightDataLockedAt;
+    for (int i = sectorCount - 1; i >= 0; i--) pthread_mutex_unlock(&sectorDataLocks[i]);
+    pthread_mutex_unlock(&flightDataMutex);
+    recordLatency(METRIC_FLIGHT_DATA_HOLD, held);
+}
+
+// Rewrites the stats file through a rename so readers never see a torn copy.
+void writeStatsFile(const char* path) {
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* out = fopen(tmpPath, "w");
+    if (!out) return;
+    fprintf(out, "# latency in microseconds\n");
+    fprintf(out, "%-18s %10s %10s %10s %10s %10s %10s %10s\n",
+            "metric", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        LatencyHistogram* h = &metrics[i];
+        uint64_t total = atomic_load_explicit(&h->total, memory_order_relaxed);
+        double mean = total ? atomic_load_explicit(&h->sum, memory_order_relaxed) / (double)total : 0;
+        fprintf(out, "%-18s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                metricNames[i], (unsigned long long)total, mean / 1000.0,
+                histogramPercentile(h, 50) / 1000.0, histogramPercentile(h, 90) / 1000.0,
+                histogramPercentile(h, 99) / 1000.0, histogramPercentile(h, 99.9) / 1000.0,
+                atomic_load_explicit(&h->max, memory_order_relaxed) / 1000.0);
+    }
+    fprintf(out, "\n");
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        fprintf(out, "%-18s %10llu\n", counterNames[i],
+                (unsigned long long)atomic_load_explicit(&counters[i], memory_order_relaxed));
+    }
+    fclose(out);
+    rename(tmpPath, path);
+}
+
+void* statsThread(void* arg) {
+    (void)arg;
+    while (atomic_load(&statsRunning)) {
+        writeStatsFile(statsFilePath);
+        for (int i = 0; i < 10 && atomic_load(&statsRunning); i++) usleep(100000);
+    }
+    writeStatsFile(statsFilePath);
+    return NULL;
+}
+
+void statsInit() {
+    if (!statsFilePath) return;
+    atomic_store(&statsRunning, true);
+    if (pthread_create(&statsThreadId, NULL, statsThread, NULL) != 0) {
+        perror("Failed to start stats writer");
+        atomic_store(&statsRunning, false);
+    }
+}
+
+void statsShutdown() {
+    if (!atomic_load(&statsRunning)) return;
+    atomic_store(&statsRunning, false);
+    pthread_join(statsThreadId, NULL);
+}
+
 typedef struct {
-    char name[30];
     char id[20];
     int airlineId;
     FlightType type;
@@ -65,15 +423,16 @@ typedef struct {
     float targetY;
     float velocityX; 
     float velocityY;
+    float altitudeCarry;      // climb below one foot not yet in altitude
     bool isVIP;
     time_t lastReportedViolation;
+    RngStream rng;
     sfSprite* sprite;
 } Flight;
 
 Flight assignFlight(Flight* src) {
     Flight dest;
     strcpy(dest.id, src->id);
-    strcpy(dest.name, src->name);
     dest.airlineId = src->airlineId;
     dest.type = src->type;
     dest.phase = src->phase;
@@ -98,35 +457,336 @@ Flight assignFlight(Flight* src) {
     dest.targetY = src->targetY;
     dest.velocityX = src->velocityX;
     dest.velocityY = src->velocityY;
+    dest.altitudeCarry = src->altitudeCarry;
     dest.isVIP = src->isVIP;
     dest.lastReportedViolation = src->lastReportedViolation;
+    dest.rng = src->rng;
     return dest;
 }
 
+typedef enum { ICON_COMMERCIAL, ICON_CARGO, ICON_EMERGENCY, ICON_MILITARY } AirlineIcon;
+
 typedef struct {
-    char name[30];
+    const char* name;       // interned; only read for display
     FlightType type;
     int totalAircrafts;
     int activeFlights;
     int violations;
+    AirlineIcon icon;
 } Airline;
 
+// Airline registry. Airlines are dense integer ids everywhere, including on
+// the FIFOs to avn and stipepay; each name is interned once when the
+// registry is loaded and looked up only to display it. The ATC process
+// publishes the names to AIRLINE_REGISTRY_FILE, one per line in id order,
+// for the other two processes.
+
+Airline airlineRegistry[MAX_AIRLINES];
+int airlineCount = 0;
+
+bool addAirline(const char* name, FlightType type, int totalAircrafts, int activeFlights, AirlineIcon icon) {
+    if (airlineCount >= MAX_AIRLINES) return false;
+    char* interned = strdup(name);
+    if (!interned) return false;
+    airlineRegistry[airlineCount++] = (Airline){ interned, type, totalAircrafts, activeFlights, 0, icon };
+    return true;
+}
+
+void loadDefaultAirlines() {
+    addAirline("PIA", COMMERCIAL, 6, 4, ICON_COMMERCIAL);
+    addAirline("AirBlue", COMMERCIAL, 4, 4, ICON_COMMERCIAL);
+    addAirline("FedEx", CARGO, 3, 2, ICON_CARGO);
+    addAirline("Pakistan Airforce", EMERGENCY, 2, 1, ICON_MILITARY);
+    addAirline("Blue Dart", CARGO, 2, 2, ICON_CARGO);
+    addAirline("AghaKhan Air", EMERGENCY, 2, 1, ICON_EMERGENCY);
+}
+
+bool isValidAirline(int airlineId) {
+    return airlineId >= 0 && airlineId < airlineCount;
+}
+
+// Writes the registry names for avn and stipepay through a rename, so they
+// never read a partial list.
+void publishAirlineRegistry() {
+    char temp[64];
+    snprintf(temp, sizeof(temp), "%s.tmp", AIRLINE_REGISTRY_FILE);
+    FILE* file = fopen(temp, "w");
+    if (!file) {
+        perror("Failed to write airline registry");
+        return;
+    }
+    for (int i = 0; i < airlineCount; i++) fprintf(file, "%s\n", airlineRegistry[i].name);
+    fclose(file);
+    if (rename(temp, AIRLINE_REGISTRY_FILE) < 0) perror("Failed to publish airline registry");
+}
+
+// traceId and detectedNs follow a violation through avn.c and stipepay.c.
+// CLOCK_MONOTONIC is shared by every process on the host, so the later
+// stages can extend the same timeline.
 typedef struct {
     Flight flight;
+    uint64_t traceId;
+    uint64_t detectedNs;
 } AVNData;
 
-AVNData avn;
+_Atomic uint32_t nextTraceSequence = 0;
+
+void stampAVNTrace(AVNData* data) {
+    data->traceId = ((uint64_t)getpid() << 32) | (atomic_fetch_add(&nextTraceSequence, 1) + 1);
+    data->detectedNs = monotonicNs();
+}
+
+// --avn-socket: send notices over one SOCK_SEQPACKET connection instead of
+// reopening the ATCtoAVN FIFO per notice. Each write is one message, so
+// several ATC instances can share one avn, and the hello sent on connect
+// names this sector in the AVN report.
+#define AVN_HELLO_MAGIC "AVNHELO"
+
+typedef struct {
+    char magic[8];
+    char sector[32];
+    int pid;
+} AVNHello;
+
+const char* avnSocketPath = NULL;
+const char* sectorName = NULL;
+int avnSocketFd = -1;
+
+bool connectAVNSocket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("socket failed");
+        return false;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("Failed to connect to AVN socket");
+        close(fd);
+        return false;
+    }
+    AVNHello hello;
+    memset(&hello, 0, sizeof(hello));
+    memcpy(hello.magic, AVN_HELLO_MAGIC, sizeof(hello.magic));
+    if (sectorName) snprintf(hello.sector, sizeof(hello.sector), "%s", sectorName);
+    else snprintf(hello.sector, sizeof(hello.sector), "ATC-%d", (int)getpid());
+    hello.pid = getpid();
+    write(fd, &hello, sizeof(hello));
+    // A vanished avn should surface as a failed write, not kill the ATC.
+    signal(SIGPIPE, SIG_IGN);
+    avnSocketFd = fd;
+    return true;
+}
+
+// The socket stays open for the whole run; only FIFO descriptors are closed
+// after each notice.
+int openAVNOutput(const char* fifoPath) {
+    if (!avnOutputEnabled) return -1;
+    if (avnSocketFd >= 0) return avnSocketFd;
+    return open(fifoPath, O_WRONLY);
+}
+
+void closeAVNOutput(int fd) {
+    if (fd >= 0 && fd != avnSocketFd) close(fd);
+}
+
+// Binary event trace (--record). Fixed 64-byte records are appended under
+// one mutex so the file keeps the exact order in which state changed; a
+// recorded run can then be replayed with --replay at full speed.
+#define TRACE_MAGIC "ATCTRC2"
+
+typedef enum {
+    TRACE_FLIGHT_CREATED,
+    TRACE_RUNWAY_ASSIGNED,
+    TRACE_LOCK_GRANT,
+    TRACE_LOCK_RELEASE,
+    TRACE_PHASE_ENTERED,
+    TRACE_FAULT,
+    TRACE_VIOLATION,
+    TRACE_FLIGHT_DONE,
+    TRACE_FLIGHT_ID           // follows each TRACE_FLIGHT_CREATED; values hold the id text
+} TraceEventType;
+
+#define VIOLATION_SPEED 1
+#define VIOLATION_POSITION 2
+#define VIOLATION_ALTITUDE 4
+#define VIOLATION_RUNWAY 8
+
+typedef struct {
+    uint64_t timeNs;
+    uint32_t flightIndex;
+    uint16_t type;
+    uint16_t phase;
+    int32_t values[8];
+    float x;
+    float y;
+    float targetY;
+    uint32_t reserved;
+} TraceEvent;
+
+typedef struct {
+    char magic[8];
+    uint64_t seed;
+    uint32_t flightCount;
+    uint32_t recordSize;
+    uint32_t runwayCount;     // a replay needs the same runway and airline tables
+    uint32_t airlineCount;
+} TraceHeader;
+
+FILE* traceFile = NULL;
+bool traceStopped = false;    // a trace holds one run; set once it has been closed
+pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+uint64_t traceStartNs;
+Flight* traceFlightBase = NULL;
+
+void traceWrite(TraceEvent* e) {
+    pthread_mutex_lock(&traceMutex);
+    if (traceFile) {
+        e->timeNs = monotonicNs() - traceStartNs;
+        fwrite(e, sizeof(*e), 1, traceFile);
+    }
+    pthread_mutex_unlock(&traceMutex);
+}
+
+void fillTraceEvent(TraceEvent* e, TraceEventType type, Flight* f) {
+    memset(e, 0, sizeof(*e));
+    e->flightIndex = (uint32_t)(f - traceFlightBase);
+    e->type = type;
+    e->phase = f->phase;
+    e->x = f->x;
+    e->y = f->y;
+    e->targetY = f->targetY;
+}
+
+// Events before traceSimulationStart has written the header have no store to
+// be indexed against, so they are not recorded.
+void traceFlightEvent(TraceEventType type, Flight* f, int v0, int v1, int v2, int v3, int v4) {
+    if (!traceFile || !traceFlightBase) return;
+    TraceEvent e;
+    fillTraceEvent(&e, type, f);
+    e.values[0] = v0;
+    e.values[1] = v1;
+    e.values[2] = v2;
+    e.values[3] = v3;
+    e.values[4] = v4;
+    traceWrite(&e);
+}
+
+bool openTrace(const char* path) {
+    traceFile = fopen(path, "wb");
+    if (!traceFile) {
+        perror("Failed to open trace file");
+        return false;
+    }
+    return true;
+}
+
+void closeTrace() {
+    if (!traceFile) return;
+    pthread_mutex_lock(&traceMutex);
+    fclose(traceFile);
+    traceFile = NULL;
+    traceStopped = true;
+    pthread_mutex_unlock(&traceMutex);
+}
 
 typedef struct {
     Flight* flights;
     int flightCount;
 } ThreadData;
 
-Flight* runwayAQueue[MAX_FLIGHTS];
-Flight* runwayBQueue[MAX_FLIGHTS];
-Flight* runwayCQueue[MAX_FLIGHTS];
-int runwayACount = 0, runwayBCount = 0, runwayCCount = 0;
+// Runway layout. The defaults reproduce the original three-runway airport;
+// --runways replaces them with a configuration file.
+#define RUNWAY_ARRIVALS 1
+#define RUNWAY_DEPARTURES 2
+#define RUNWAY_EMERGENCY 1   // takes emergencies and low-fuel diversions
+#define RUNWAY_FALLBACK 2    // takes what no regular runway accepts
+
+typedef struct {
+    char name[16];
+    uint8_t operations;
+    uint8_t directions;   // bit per Direction
+    uint8_t types;        // bit per FlightType
+    uint8_t flags;
+    float laneX[4];       // screen x per Direction
+    Flight** queue;
+    int queueCount;
+} RunwayConfig;
+
+RunwayConfig runways[MAX_RUNWAYS];
+int runwayCount = 0;
 
+bool addRunway(const char* name, uint8_t operations, uint8_t directions, uint8_t types, uint8_t flags,
+               const float laneX[4]) {
+    if (runwayCount >= MAX_RUNWAYS) return false;
+    Flight** queue = malloc(sizeof(Flight*) * MAX_FLIGHTS);
+    if (!queue) return false;
+    RunwayConfig* r = &runways[runwayCount++];
+    memset(r, 0, sizeof(*r));
+    strncpy(r->name, name, sizeof(r->name) - 1);
+    r->operations = operations;
+    r->directions = directions;
+    r->types = types;
+    r->flags = flags;
+    memcpy(r->laneX, laneX, sizeof(r->laneX));
+    r->queue = queue;
+    return true;
+}
+
+void loadDefaultRunways() {
+    const float laneA[4] = {200, 40, 200, 40};
+    const float laneB[4] = {450, 360, 450, 360};
+    const float laneC[4] = {650, 650, 650, 650};
+    uint8_t allTypes = (1 << COMMERCIAL) | (1 << CARGO) | (1 << EMERGENCY) | (1 << VIP);
+    uint8_t passenger = allTypes & ~(1 << CARGO);
+    addRunway("RWY-A", RUNWAY_ARRIVALS, (1 << NORTH) | (1 << SOUTH), passenger, 0, laneA);
+    addRunway("RWY-B", RUNWAY_DEPARTURES, (1 << EAST) | (1 << WEST), passenger, 0, laneB);
+    addRunway("RWY-C", RUNWAY_ARRIVALS | RUNWAY_DEPARTURES, 0xF, allTypes, RUNWAY_EMERGENCY | RUNWAY_FALLBACK, laneC);
+}
+
+Runway fallbackRunway() {
+    for (int i = 0; i < runwayCount; i++) {
+        if (runways[i].flags & RUNWAY_FALLBACK) return i;
+    }
+    return runwayCount - 1;
+}
+
+bool isValidRunway(Runway r) {
+    return r >= 0 && r < runwayCount;
+}
+
+// Starts a recorded run: writes the header and the initial state of every
+// flight so a replay can rebuild the store without the generator.
+void traceSimulationStart(Flight* flights, int flightCount) {
+    if (traceStopped) printf("Recording stopped after the first run; this run is not recorded\n");
+    if (!traceFile) return;
+    TraceHeader header = {TRACE_MAGIC, scenarioSeed, (uint32_t)flightCount, sizeof(TraceEvent),
+                          (uint32_t)runwayCount, (uint32_t)airlineCount};
+    fwrite(&header, sizeof(header), 1, traceFile);
+    traceFlightBase = flights;
+    traceStartNs = monotonicNs();
+    for (int i = 0; i < flightCount; i++) {
+        Flight* f = &flights[i];
+        TraceEvent e;
+        fillTraceEvent(&e, TRACE_FLIGHT_CREATED, f);
+        e.values[0] = f->airlineId;
+        e.values[1] = f->isDeparture;
+        e.values[2] = f->direction;
+        e.values[3] = f->fuelLevel;
+        e.values[4] = f->priority;
+        e.values[5] = f->scheduledTime;
+        e.values[6] = (f->isEmergency ? 1 : 0) | (f->isVIP ? 2 : 0);
+        e.values[7] = f->type;
+        traceWrite(&e);
+        fillTraceEvent(&e, TRACE_FLIGHT_ID, f);
+        memcpy(e.values, f->id, sizeof(f->id));
+        traceWrite(&e);
+    }
+}
+
+bool headless = false;
 sfTexture* commercialTexture;
 sfTexture* cargoTexture;
 sfTexture* emergencyTexture;
@@ -143,6 +803,14 @@ void loadTextures() {
     }
 }
 
+sfTexture* textureForFlight(const Flight* f) {
+    AirlineIcon icon = isValidAirline(f->airlineId) ? airlineRegistry[f->airlineId].icon : ICON_COMMERCIAL;
+    if (f->type == CARGO || icon == ICON_CARGO) return cargoTexture;
+    if (icon == ICON_MILITARY) return airTexture;
+    if (f->isEmergency || icon == ICON_EMERGENCY) return emergencyTexture;
+    return commercialTexture;
+}
+
 int Flights_Comparison(const void* a, const void* b) {
     Flight* f1 = *(Flight**)a;
     Flight* f2 = *(Flight**)b;
@@ -160,9 +828,9 @@ int EmergencyPriorityComparison(const void* a, const void* b) {
 }
 
 void QueuesReordering() {
-    qsort(runwayAQueue, runwayACount, sizeof(Flight*), EmergencyPriorityComparison);
-    qsort(runwayBQueue, runwayBCount, sizeof(Flight*), EmergencyPriorityComparison);
-    qsort(runwayCQueue, runwayCCount, sizeof(Flight*), EmergencyPriorityComparison);
+    for (int r = 0; r < runwayCount; r++) {
+        qsort(runways[r].queue, runways[r].queueCount, sizeof(Flight*), EmergencyPriorityComparison);
+    }
 }
 
 void sortQueue(Flight** queue, int count) {
@@ -197,20 +865,12 @@ const char* getFlightTypeString(FlightType t) {
 }
 
 const char* getRunwayString(Runway r) {
-    if (r == RWY_A) return "RWY-A";
-    else if (r == RWY_B) return "RWY-B";
-    else if (r == RWY_C) return "RWY-C";
+    if (isValidRunway(r)) return runways[r].name;
     else return "NO_RUNWAY";
 }
 
-const char* getAirlineName(int airlineId) {
-    if (airlineId == 0) return "PIA";
-    else if (airlineId == 1) return "AirBlue";
-    else if (airlineId == 2) return "FedEx";
-    else if (airlineId == 3) return "Pakistan Airforce";
-    else if (airlineId == 4) return "Blue Dart";
-    else if (airlineId == 5) return "AghaKhan Air";
-    else return "Unknown Airline";
+const char* airlineName(int airlineId) {
+    return isValidAirline(airlineId) ? airlineRegistry[airlineId].name : "Unknown Airline";
 }
 
 int getMinAllowedSpeed(FlightPhase phase) {
@@ -270,15 +930,28 @@ static inline bool check_speedViolation(Flight* f) {
     else return false;
 }
 
+typedef struct {
+    int min;
+    int max;
+} AltitudeRange;
+
+AltitudeRange getAltitudeEnvelopeForPhase(FlightPhase phase) {
+    switch (phase) {
+        case HOLDING: return (AltitudeRange){10000, 15000};
+        case APPROACH: return (AltitudeRange){3000, 10000};
+        case LANDING: return (AltitudeRange){0, 3000};
+        case TAXI: return (AltitudeRange){0, 0};
+        case AT_GATE: return (AltitudeRange){0, 0};
+        case TAKEOFF_ROLL: return (AltitudeRange){0, 100};
+        case CLIMB: return (AltitudeRange){1000, 30000};
+        case CRUISE: return (AltitudeRange){30000, 166670};
+        default: return (AltitudeRange){INT_MIN, INT_MAX};
+    }
+}
+
 static inline bool check_altitudeViolation(Flight* f) {
-    if (f->phase == HOLDING) return f->altitude > 15000 || f->altitude < 10000;
-    else if (f->phase == APPROACH) return f->altitude > 10000 || f->altitude < 3000;
-    else if (f->phase == LANDING) return f->altitude > 3000 || f->altitude < 0;
-    else if (f->phase == TAXI || f->phase == AT_GATE) return f->altitude != 0;
-    else if (f->phase == TAKEOFF_ROLL) return f->altitude > 100 || f->altitude < 0;
-    else if (f->phase == CLIMB) return f->altitude < 1000 || f->altitude > 30000;
-    else if (f->phase == CRUISE) return f->altitude < 30000 || f->altitude > 166670;
-    else return false;
+    AltitudeRange envelope = getAltitudeEnvelopeForPhase(f->phase);
+    return f->altitude < envelope.min || f->altitude > envelope.max;
 }
 
 static inline bool check_positionViolation(Flight* f) {
@@ -287,81 +960,195 @@ static inline bool check_positionViolation(Flight* f) {
 }
 
 static inline bool check_RunwayDirection(Flight* f) {
-    if (f->direction == NORTH || f->direction == SOUTH) {
-        return f->assignedRunway == RWY_A || f->assignedRunway == RWY_C;
+    if (!isValidRunway(f->assignedRunway) || f->direction > WEST) return false;
+    return runways[f->assignedRunway].directions & (1 << f->direction);
+}
+
+static inline bool isRunwayTypeValid(Flight* f) {
+    if (f->isEmergency) return true;
+    return isValidRunway(f->assignedRunway) && (runways[f->assignedRunway].types & (1 << f->type));
+}
+
+static inline bool isRunwayViolation(Flight* f) {
+    return !check_RunwayDirection(f) || !isRunwayTypeValid(f);
+}
+
+int violationMask(Flight* f) {
+    return (check_speedViolation(f) ? VIOLATION_SPEED : 0) |
+           (check_positionViolation(f) ? VIOLATION_POSITION : 0) |
+           (check_altitudeViolation(f) ? VIOLATION_ALTITUDE : 0) |
+           (isRunwayViolation(f) ? VIOLATION_RUNWAY : 0);
+}
+
+// Violation index. The dashboard and the summary log read their counts from
+// here instead of rescanning every flight: each path that changes a flight's
+// phase, envelope values, runway, emergency state or AVN record calls
+// noteFlightChanged(), which moves that one flight's contribution.
+#define VIOLATION_KINDS 4
+#define VIOLATION_KIND_RUNWAY 3   // bit index of VIOLATION_RUNWAY
+#define FLIGHT_PHASE_COUNT (CRUISE + 1)
+
+typedef struct {
+    bool tracked;
+    bool listed;         // in activeViolators
+    bool emergency;
+    uint8_t mask;        // VIOLATION_* bits
+    uint8_t phase;
+    int airlineId;
+    int avnCount;
+    int activeSlot;
+} ViolationEntry;
+
+typedef struct {
+    Flight* base;
+    ViolationEntry* entries;
+    int* activeViolators;   // flights with an active or past AVN
+    int activeCount;
+    int kindCounts[VIOLATION_KINDS];
+    int airlineViolators[MAX_AIRLINES];
+    int airlineAVNs[MAX_AIRLINES];
+    int phaseViolators[FLIGHT_PHASE_COUNT];
+    int avnTriggers;
+    int emergencies;
+    uint64_t generation;
+} ViolationIndex;
+
+ViolationIndex violationIndex;
+pthread_mutex_t violationIndexLock = PTHREAD_MUTEX_INITIALIZER;
+const char* violationKindNames[VIOLATION_KINDS] = { "Speed", "Position", "Altitude", "Runway" };
+
+bool violationIndexInit(Flight* flights) {
+    violationIndex.entries = calloc(MAX_FLIGHTS, sizeof(ViolationEntry));
+    violationIndex.activeViolators = malloc(sizeof(int) * MAX_FLIGHTS);
+    if (!violationIndex.entries || !violationIndex.activeViolators) {
+        perror("Failed to allocate violation index");
+        return false;
+    }
+    violationIndex.base = flights;
+    return true;
+}
+
+void countViolationEntry(const ViolationEntry* e, int sign) {
+    ViolationIndex* v = &violationIndex;
+    bool knownAirline = isValidAirline(e->airlineId);
+    for (int k = 0; k < VIOLATION_KINDS; k++) {
+        if (e->mask & (1 << k)) v->kindCounts[k] += sign;
     }
-    else if (f->direction == EAST || f->direction == WEST) {
-        return f->assignedRunway == RWY_B || f->assignedRunway == RWY_C;
+    if (e->mask) {
+        if (e->phase < FLIGHT_PHASE_COUNT) v->phaseViolators[e->phase] += sign;
+        if (knownAirline) v->airlineViolators[e->airlineId] += sign;
     }
-    else return false;
+    if (knownAirline) v->airlineAVNs[e->airlineId] += sign * e->avnCount;
+    v->avnTriggers += sign * e->avnCount;
+    if (e->emergency) v->emergencies += sign;
 }
 
-static inline bool isCargoRunwayValid(Flight* f) {
-    return (f->type != CARGO || f->assignedRunway == RWY_C || f->isEmergency);
+void noteFlightChanged(Flight* f) {
+    ViolationIndex* v = &violationIndex;
+    if (!v->base || f < v->base || f >= v->base + MAX_FLIGHTS) return;
+    int i = (int)(f - v->base);
+    ViolationEntry* e = &v->entries[i];
+    bool active = f->avnStatus == ACTIVE || f->avnCount > 0;
+    // Only the thread driving a flight updates its entry, so it can skip the
+    // shared lock on the common tick where nothing it counts has changed.
+    if (e->tracked && e->mask == (uint8_t)violationMask(f) && e->phase == (uint8_t)f->phase &&
+        e->airlineId == f->airlineId && e->avnCount == f->avnCount && e->emergency == f->isEmergency &&
+        e->listed == active) return;
+    pthread_mutex_lock(&violationIndexLock);
+    if (e->tracked) countViolationEntry(e, -1);
+    e->tracked = true;
+    e->mask = (uint8_t)violationMask(f);
+    e->phase = (uint8_t)f->phase;
+    e->airlineId = f->airlineId;
+    e->avnCount = f->avnCount;
+    e->emergency = f->isEmergency;
+    countViolationEntry(e, 1);
+    if (active && !e->listed) {
+        e->listed = true;
+        e->activeSlot = v->activeCount;
+        v->activeViolators[v->activeCount++] = i;
+    } else if (!active && e->listed) {
+        int last = v->activeViolators[--v->activeCount];
+        v->activeViolators[e->activeSlot] = last;
+        v->entries[last].activeSlot = e->activeSlot;
+        e->listed = false;
+    }
+    v->generation++;
+    pthread_mutex_unlock(&violationIndexLock);
 }
 
-static inline bool isRunwayViolation(Flight* f) {
-    return !check_RunwayDirection(f) || !isCargoRunwayValid(f);
+// The violation mask the index last recorded for f, or -1 before its first
+// note. Read by the thread driving f, the only one that writes its entry.
+int indexedViolationMask(Flight* f) {
+    ViolationIndex* v = &violationIndex;
+    if (!v->base || f < v->base || f >= v->base + MAX_FLIGHTS) return -1;
+    ViolationEntry* e = &v->entries[f - v->base];
+    return e->tracked ? e->mask : -1;
+}
+
+// Forgets the first count flights when the store is cleared for a new batch.
+void clearViolationIndex(int count) {
+    ViolationIndex* v = &violationIndex;
+    if (!v->base) return;
+    pthread_mutex_lock(&violationIndexLock);
+    memset(v->entries, 0, sizeof(ViolationEntry) * count);
+    v->activeCount = 0;
+    memset(v->kindCounts, 0, sizeof(v->kindCounts));
+    memset(v->airlineViolators, 0, sizeof(v->airlineViolators));
+    memset(v->airlineAVNs, 0, sizeof(v->airlineAVNs));
+    memset(v->phaseViolators, 0, sizeof(v->phaseViolators));
+    v->avnTriggers = 0;
+    v->emergencies = 0;
+    v->generation++;
+    pthread_mutex_unlock(&violationIndexLock);
+}
+
+int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
 }
 
 void checkForFaults(Flight* f) {
     if (f->phase == TAXI || f->phase == AT_GATE) {
-        if (rand() % 100 < 5) {
+        if (rngBelow(&f->rng, 100) < 5) {
             f->hasFault = true;
-            printf("FAULT DETECTED! Flight %s has ground fault\n", f->id);
+            LOG_FLIGHT(LOG_WARN, EV_FAULT, f, 0, 0, 0, 0);
+            traceFlightEvent(TRACE_FAULT, f, 0, 0, 0, 0, 0);
         }
     }
 }
 
+void placeOnRunway(Flight* f, Runway r) {
+    float x = runways[r].laneX[f->direction <= WEST ? f->direction : NORTH];
+    f->targetX = x;
+    f->x = x;
+}
+
+bool runwayAccepts(const RunwayConfig* r, const Flight* f) {
+    uint8_t operation = f->isDeparture ? RUNWAY_DEPARTURES : RUNWAY_ARRIVALS;
+    return (r->operations & operation) && f->direction <= WEST && (r->directions & (1 << f->direction)) &&
+           (r->types & (1 << f->type)) && r->queueCount < MAX_FLIGHTS;
+}
+
+// Emergencies go to the least loaded emergency runway, everything else to the
+// least loaded regular runway that accepts it, or to a fallback runway.
 Runway assignRunway(Flight* f) {
-    if (f->isEmergency || f->fuelLevel < FUEL_THRESHOLD) 
-    {   
-        f->targetX = 650;
-        f->x=650;
-        return RWY_C;
-    }
-    if (f->type == CARGO) 
-    {
-        f->targetX = 650;
-        f->x=650;
-        return RWY_C;
-    }
-    if (f->isDeparture) {
-        if (runwayBCount < MAX_FLIGHTS && (f->direction == EAST || f->direction == WEST)) 
-        {
-            if(f->direction == WEST)
-            {
-                f->targetX = 360;
-                f->x=360;
-            }
-            else
-            {
-                f->targetX = 450;
-                f->x=450;
-            }
-            return RWY_B;
-        }
-        f->targetX = 650;
-        f->x=650;
-        return RWY_C;
-    }
-    if (runwayACount < MAX_FLIGHTS && (f->direction == NORTH || f->direction == SOUTH)) 
-    {
-        if(f->direction == SOUTH)
-        {
-        f->targetX = 40;
-        f->x=40;
-        }
-        else
-        {
-        f->targetX = 200;
-        f->x=200;
+    bool emergency = f->isEmergency || f->fuelLevel < FUEL_THRESHOLD;
+    Runway best = NO_RUNWAY;
+    for (int pass = emergency ? 0 : 1; pass < 3 && best == NO_RUNWAY; pass++) {
+        for (int i = 0; i < runwayCount; i++) {
+            RunwayConfig* r = &runways[i];
+            bool eligible;
+            if (pass == 0) eligible = r->flags & RUNWAY_EMERGENCY;
+            else if (pass == 1) eligible = !(r->flags & RUNWAY_FALLBACK) && runwayAccepts(r, f);
+            else eligible = r->flags & RUNWAY_FALLBACK;
+            if (eligible && (best == NO_RUNWAY || r->queueCount < runways[best].queueCount)) best = i;
         }
-        return RWY_A;
     }
-    f->targetX = 650;
-    f->x=650;
-    return RWY_C;
+    if (best == NO_RUNWAY) best = fallbackRunway();
+    placeOnRunway(f, best);
+    return best;
 }
 
 void printFlightStatus(Flight flights[], int flightCount) {
@@ -370,33 +1157,36 @@ void printFlightStatus(Flight flights[], int flightCount) {
     printf("--------------------------------\n");
     for (int i = 0; i < flightCount; i++) {
         printf("Flight %s | %s | %s | %s | Runway: %s | Wait: %ds\n",
-               flights[i].id, getAirlineName(flights[i].airlineId),
+               flights[i].id, airlineName(flights[i].airlineId),
                getFlightTypeString(flights[i].type), getPhaseString(flights[i].phase),
                getRunwayString(flights[i].assignedRunway), flights[i].estimatedWait);
     }
 }
 
+// Where a flight first appears, and which way its sprite faces, follow its
+// direction of travel.
+void placeFlightForDirection(Flight* f) {
+    bool reversed = f->direction == NORTH || f->direction == EAST;
+    if (reversed) f->y = 250;
+    else f->y = f->isDeparture ? 300 : 380;
+    if (f->sprite) {
+        sfSprite_setRotation(f->sprite, reversed ? 180.0f : 0);
+        sfSprite_setPosition(f->sprite, (sfVector2f){f->x, f->y});
+    }
+}
+
 Flight generateFlight(Airline airlines[], int airlineId, int timeCounter, const char* flightId, bool isDeparture) {
     Flight f = { 0 };
     
     strncpy(f.id, flightId, sizeof(f.id) - 1);
+    rngSeed(&f.rng, scenarioSeed, streamIdFor(f.id));
     f.airlineId = airlineId;
     f.isDeparture = isDeparture;
     f.lastUpdated = time(NULL);
     f.assignedRunway = NO_RUNWAY;
     f.lastReportedViolation = 0;
-    f.sprite = sfSprite_create();
-    sfSprite_setTexture(f.sprite, commercialTexture, sfTrue);
-    if (f.type == CARGO) {
-        sfSprite_setTexture(f.sprite, cargoTexture, sfTrue);
-    } else if (f.isEmergency || airlineId == 5) {
-        sfSprite_setTexture(f.sprite, emergencyTexture, sfTrue);
-    } else if (airlineId == 3) {
-        sfSprite_setTexture(f.sprite, airTexture, sfTrue);
-    }
-    Airline airline = airlines[airlineId];
-    f.type = airline.type;
-    strncpy(f.name, airline.name, sizeof(f.name) - 1);
+    const Airline* airline = &airlines[airlineId];
+    f.type = airline->type;
     f.isEmergency = false;
     f.isVIP = false;
     if (isDeparture) {
@@ -405,49 +1195,38 @@ Flight generateFlight(Airline airlines[], int airlineId, int timeCounter, const
         f.altitude = 0;
         f.phase = AT_GATE;
     } else {
-        f.fuelLevel = rand() % 101;
-        f.position = rand() % 401 + 300;
+        f.fuelLevel = rngBelow(&f.rng, 101);
+        f.position = rngBelow(&f.rng, 401) + 300;
         f.altitude = 9000;
         f.phase = HOLDING;
     }
-    if (f.fuelLevel < FUEL_THRESHOLD || airlineId == 3 || airlineId == 5) {
+    if (f.fuelLevel < FUEL_THRESHOLD || airline->type == EMERGENCY) {
         f.isEmergency = true;
         f.priority = 3;
     }
     if (isDeparture) {
-        f.direction = (rand() % 2) ? EAST : WEST;
+        f.direction = rngBelow(&f.rng, 2) ? EAST : WEST;
     } else {
-        f.direction = (rand() % 2) ? NORTH : SOUTH;
+        f.direction = rngBelow(&f.rng, 2) ? NORTH : SOUTH;
     }
     f.hasFault = false;
     f.avnStatus = INACTIVE;
     f.avnCount = 0;
-    if(f.direction == NORTH || f.direction == EAST)
-    {
-        f.y = 250;
-        sfSprite_setRotation(f.sprite, 180);
-
-    }
-    else
-    { 
-        if(!f.isDeparture)
-        f.y = 380;
-        else
-        f.y = 300;
-    }
-    sfSprite_setPosition(f.sprite, (sfVector2f){f.x, f.y});
-    sfSprite_setScale(f.sprite, (sfVector2f){0.5f, 0.5f});
+    f.sprite = headless ? NULL : sfSprite_create();
+    if (f.sprite) sfSprite_setTexture(f.sprite, textureForFlight(&f), sfTrue);
+    if (f.sprite) sfSprite_setScale(f.sprite, (sfVector2f){0.5f, 0.5f});
+    placeFlightForDirection(&f);
 
     
     return f;
 }
 
-void setTaxiSpeed(Flight* f) { f->speed = rand() % 16 + 15; }
-void setHoldingSpeed(Flight* f) { f->speed = rand() % 201 + 400; }
-void setApproachSpeed(Flight* f) { f->speed = rand() % 51 + 240; }
-void setLandingSpeed(Flight* f) { f->speed = rand() % 211 + 30; }
-void setClimbSpeed(Flight* f) { f->speed = rand() % 214 + 250; }
-void setTakeoffRollSpeed(Flight* f) { f->speed = rand() % 291; }
+void setTaxiSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 16) + 15; }
+void setHoldingSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 201) + 400; }
+void setApproachSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 51) + 240; }
+void setLandingSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 211) + 30; }
+void setClimbSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 214) + 250; }
+void setTakeoffRollSpeed(Flight* f) { f->speed = rngBelow(&f->rng, 291); }
 void setInitialSpeedForGate(Flight* f) { f->speed = 0; }
 void transitionToTakeoffRoll(Flight* f) { f->speed = 0; }
 void transitionToCruise(Flight* f) {
@@ -458,19 +1237,22 @@ void activateAVN(Flight* f) {
     if (f->avnStatus == INACTIVE) {
         f->avnStatus = ACTIVE;
         avnTriggered = true;
-        printf("\n!!! AVN ACTIVATED for Flight %s !!!\n", f->id);
+        LOG_FLIGHT(LOG_WARN, EV_AVN_ACTIVATED, f, 0, 0, 0, 0);
     }
 }
 
 void handleAVNspeed(Flight* f) {
+    AVNData avn;
     char arr[20] = "ATCtoAVN";
     if (mkfifo(arr, 0666) < 0 && errno != EEXIST) {
         perror("mkfifo failed");
         return;
     }
     if (check_speedViolation(f)) {
-        printf("\033[1;31m!!!! Speed Violation has Occurred !!!!\033[0m\n");
-        int fd = open(arr, O_WRONLY);
+        LOG_FLIGHT(LOG_WARN, EV_SPEED_VIOLATION, f, f->phase, f->speed, 0, 0);
+        stampAVNTrace(&avn);
+        uint64_t writeStart = monotonicNs();
+        int fd = openAVNOutput(arr);
         activateAVN(f);
         f->avnCount++;
         int minSpeed = getMinAllowedSpeed(f->phase);
@@ -481,13 +1263,16 @@ void handleAVNspeed(Flight* f) {
             newSpeed = minSpeed + (f->speed - minSpeed)/2;
         }
         avn.flight = assignFlight(f);
-        write(fd, &avn, sizeof(AVNData));
+        if (fd >= 0) write(fd, &avn, sizeof(AVNData));
         f->speed = newSpeed;
-        close(fd);
+        closeAVNOutput(fd);
+        recordLatency(METRIC_AVN_FIFO_WRITE, monotonicNs() - writeStart);
+        countEvent(COUNTER_AVN_NOTICES);
     }
 }
 
 void handleAVNposition(Flight* f) {
+    AVNData avn;
     PositionRange safeRange = getSafePositionRangeForPhase(f->phase);
     char arr[20] = "ATCtoAVN";
     if (mkfifo(arr, 0666) < 0 && errno != EEXIST) {
@@ -495,14 +1280,20 @@ void handleAVNposition(Flight* f) {
         return;
     }
     if (f->position < safeRange.min || f->position > safeRange.max) {
-        printf("\033[1;31m!!!! Position Violation has Occurred !!!!\033[0m\n");
-        int fd = open(arr, O_WRONLY);
+        LOG_FLIGHT(LOG_WARN, EV_POSITION_VIOLATION, f, f->phase, f->position, 0, 0);
+        stampAVNTrace(&avn);
+        uint64_t writeStart = monotonicNs();
+        int fd = openAVNOutput(arr);
         activateAVN(f);
         f->avnCount++;
         int newPosition;
         avn.flight = assignFlight(f);
-        write(fd, &avn, sizeof(AVNData));
-        close(fd);
+        if (fd >= 0) {
+            write(fd, &avn, sizeof(AVNData));
+            closeAVNOutput(fd);
+        }
+        recordLatency(METRIC_AVN_FIFO_WRITE, monotonicNs() - writeStart);
+        countEvent(COUNTER_AVN_NOTICES);
         if (f->position < safeRange.min) {
             newPosition = safeRange.min + (safeRange.max - safeRange.min)/4;
         } else {
@@ -513,6 +1304,7 @@ void handleAVNposition(Flight* f) {
 }
 
 void handleAVNaltitude(Flight* f) {
+    AVNData avn;
     int safeAltitude = getSafeAltitudeForPhase(f->phase);
     int tolerance = 500;
     char arr[20] = "ATCtoAVN";
@@ -521,8 +1313,10 @@ void handleAVNaltitude(Flight* f) {
         return;
     }
     if (abs(f->altitude - safeAltitude) > tolerance) {
-        printf("\033[1;31m!!!! Altitude Violation has Occurred !!!!\033[0m\n");
-        int fd = open(arr, O_WRONLY);
+        LOG_FLIGHT(LOG_WARN, EV_ALTITUDE_VIOLATION, f, f->phase, f->altitude, 0, 0);
+        stampAVNTrace(&avn);
+        uint64_t writeStart = monotonicNs();
+        int fd = openAVNOutput(arr);
         activateAVN(f);
         f->avnCount++;
         int newAltitude;
@@ -532,18 +1326,25 @@ void handleAVNaltitude(Flight* f) {
             newAltitude = safeAltitude + tolerance/2;
         }
         avn.flight = assignFlight(f);
-        write(fd, &avn, sizeof(AVNData));
-        close(fd);
+        if (fd >= 0) {
+            write(fd, &avn, sizeof(AVNData));
+            closeAVNOutput(fd);
+        }
+        recordLatency(METRIC_AVN_FIFO_WRITE, monotonicNs() - writeStart);
+        countEvent(COUNTER_AVN_NOTICES);
         f->altitude = newAltitude;
     }
 }
 
 bool checkForViolations(Flight* f, char* violation_msg, size_t msg_size) {
     bool violationDetected = false;
+    int avnBefore = f->avnCount;
+    int mask = 0;
     time_t now = time(NULL);
     violation_msg[0] = '\0';
     char temp_msg[256];
     if (check_speedViolation(f)) {
+        mask |= VIOLATION_SPEED;
         handleAVNspeed(f);
         int minSpeed = getMinAllowedSpeed(f->phase);
         snprintf(temp_msg, sizeof(temp_msg), "Speed Violation: %d km/h (Safe: %d+)", f->speed, minSpeed);
@@ -551,6 +1352,7 @@ bool checkForViolations(Flight* f, char* violation_msg, size_t msg_size) {
         violationDetected = true;
     }
     if (check_positionViolation(f)) {
+        mask |= VIOLATION_POSITION;
         handleAVNposition(f);
         PositionRange safeRange = getSafePositionRangeForPhase(f->phase);
         snprintf(temp_msg, sizeof(temp_msg), "%sPosition Violation: %d (Safe: %d-%d)",
@@ -559,6 +1361,7 @@ bool checkForViolations(Flight* f, char* violation_msg, size_t msg_size) {
         violationDetected = true;
     }
     if (check_altitudeViolation(f)) {
+        mask |= VIOLATION_ALTITUDE;
         handleAVNaltitude(f);
         int safeAltitude = getSafeAltitudeForPhase(f->phase);
         snprintf(temp_msg, sizeof(temp_msg), "%sAltitude Violation: %d ft (Safe: %d ft)",
@@ -567,6 +1370,7 @@ bool checkForViolations(Flight* f, char* violation_msg, size_t msg_size) {
         violationDetected = true;
     }
     if (isRunwayViolation(f)) {
+        mask |= VIOLATION_RUNWAY;
         snprintf(temp_msg, sizeof(temp_msg), "%sRunway Violation: %s (Direction: %s)",
                  violation_msg[0] ? "; " : "", getRunwayString(f->assignedRunway),
                  getDirectionString(f->direction));
@@ -576,7 +1380,11 @@ bool checkForViolations(Flight* f, char* violation_msg, size_t msg_size) {
     if (violationDetected) {
         f->lastUpdated = now;
         f->lastReportedViolation = now;
+        traceFlightEvent(TRACE_VIOLATION, f, mask, f->speed, f->altitude, f->position, f->avnCount);
     }
+    // Phase, runway and emergency changes are noted where they happen; a tick
+    // only has to report a new AVN or a flight crossing an envelope edge.
+    if (f->avnCount != avnBefore || violationMask(f) != indexedViolationMask(f)) noteFlightChanged(f);
     return violationDetected;
 }
 
@@ -645,457 +1453,4781 @@ void initializeFlightPosition(Flight* f) {
     
 }
 
-float lerp(float start, float end, float t) {
-    return start + (end - start) * t;
+// Kinematics. A flight flies straight for its phase target at its current
+// speed and climbs or descends at its phase's rate. The table gives screen
+// pixels covered per second at 1 km/h, and climb rate in feet per second, by
+// phase. The airport surface is drawn at a larger scale than the airspace,
+// so ground phases cover more pixels per km/h.
+typedef struct {
+    float pixelsPerKmh;
+    float climbRate;
+} PhaseKinematics;
+
+const PhaseKinematics phaseKinematics[] = {
+    [HOLDING] = {0.4f, 0},
+    [APPROACH] = {0.4f, -800 / 60.0f},
+    [LANDING] = {0.6f, -700 / 60.0f},
+    [TAXI] = {4.0f, 0},
+    [AT_GATE] = {4.0f, 0},
+    [TAKEOFF_ROLL] = {1.0f, 0},
+    [CLIMB] = {0.4f, 2500 / 60.0f},
+    [CRUISE] = {0.4f, 0}
+};
+
+#define PHASE_KINEMATICS_COUNT (int)(sizeof(phaseKinematics) / sizeof(phaseKinematics[0]))
+
+const PhaseKinematics* phaseKinematicsFor(FlightPhase phase) {
+    return (unsigned)phase < PHASE_KINEMATICS_COUNT ? &phaseKinematics[phase] : &phaseKinematics[HOLDING];
 }
 
+// Advances f by deltaTime; it moves at most its ground speed and stops on its
+// target rather than overshooting it. Every lifecycle tick moves one flight,
+// so this stays scalar.
 void updateFlightPosition(Flight* f, float deltaTime) {
-    // Interpolate towards target position
-    float lerpSpeed = 0.3;
-    if(lerpSpeed==0)
-    lerpSpeed=0.2f;
-    //f->x = lerp(f->x, f->targetX, lerpSpeed * deltaTime);
-    f->y = lerp(f->y, f->targetY, lerpSpeed * deltaTime);
-    // Update sprite position
-    sfSprite_setPosition(f->sprite, (sfVector2f){f->x, f->y});
+    const PhaseKinematics* phase = phaseKinematicsFor(f->phase);
+    float groundSpeed = f->speed * phase->pixelsPerKmh;
+    float dx = f->targetX - f->x;
+    float dy = f->targetY - f->y;
+    float distance = sqrtf(dx * dx + dy * dy);
+    float travel = groundSpeed * deltaTime < distance ? groundSpeed * deltaTime : distance;
+    float scale = travel / (distance > 1e-6f ? distance : 1e-6f);
+    float moveX = dx * scale;
+    float moveY = dy * scale;
+    float inverseDelta = deltaTime > 0 ? 1.0f / deltaTime : 0;
+    f->x += moveX;
+    f->y += moveY;
+    f->velocityX = moveX * inverseDelta;
+    f->velocityY = moveY * inverseDelta;
+    float altitude = f->altitude + f->altitudeCarry + phase->climbRate * deltaTime;
+    if (altitude < 0) altitude = 0;
+    // Altitude never goes negative, so truncating is flooring.
+    f->altitude = (int)altitude;
+    f->altitudeCarry = altitude - f->altitude;
 }
 
-void RealTimeSimulation(Flight* f) {
-    printf("\n--- Simulating Flight %s ---\n", f->id);
-    time_t startTime = time(NULL);
-    printf("Simulation Start Time: %s", ctime(&startTime));
-    printf("Airline: %s | Type: %s | Direction: %s | Fuel: %d%%\n",
-           getAirlineName(f->airlineId), getFlightTypeString(f->type),
-           getDirectionString(f->direction), f->fuelLevel);
-    if (f->fuelLevel < FUEL_THRESHOLD && !f->isEmergency) {
-        f->isEmergency = true;
-        printf("LOW FUEL EMERGENCY! Flight %s\n", f->id);
+// Display interpolation. Every tick publishes where its flight got to and
+// when; the render thread draws each flight between its two latest published
+// positions, one tick behind the simulation, so motion stays smooth at any
+// frame rate without the display integrating anything itself. Only the
+// thread driving a flight publishes it, under the flight's lock; the render
+// thread reads under lockFlightData.
+typedef struct {
+    float fromX, fromY;
+    float toX, toY;
+    double fromTime, toTime;
+    bool published;
+} RenderSample;
+
+typedef struct {
+    RenderSample* samples;    // one per flight slot, NULL when headless
+    Flight* base;
+} RenderTrack;
+
+RenderTrack renderTrack = { 0 };
+
+bool renderTrackInit(Flight* flights) {
+    renderTrack.samples = calloc(MAX_FLIGHTS, sizeof(RenderSample));
+    if (!renderTrack.samples) {
+        perror("Failed to allocate render track");
+        return false;
     }
-    f->assignedRunway = assignRunway(f);
-    printf("Assigned Runway: %s\n", getRunwayString(f->assignedRunway));
-    pthread_mutex_t* selectedLock = NULL;
-    switch (f->assignedRunway) {
-        case RWY_A: selectedLock = &runwayLocks[0]; break;
-        case RWY_B: selectedLock = &runwayLocks[1]; break;
-        case RWY_C: selectedLock = &runwayLocks[2]; break;
-        default: break;
-    }
-    if (selectedLock != NULL) {
-        pthread_mutex_lock(selectedLock);
-        printf("[LOCKED] %s runway in use by flight %s\n", getRunwayString(f->assignedRunway), f->id);
-    }
-    checkForFaults(f);
-    char violation_msg[MAX_VIOLATION_MSG];
-    bool isArrival = f->direction == NORTH || f->direction == SOUTH;
-    sfClock* clock = sfClock_create();
-    float phaseDuration = 2.0f; 
-    float elapsedTime = 0.0f;
-
-    if (isArrival) {
-        f->phase = HOLDING;
-        printf("Flight %s entering HOLDING phase...\n", f->id);
-        setHoldingSpeed(f);
-        f->altitude = rand() % 9001 + 8000;
-        f->position = rand() % 601 + 200;
-        initializeFlightPosition(f);
-        const char* dir = getDirectionString(f->direction);
-        if(strcmp(dir, "NORTH") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.48f, 0.48f});
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667); // ~60 FPS
-        }
-
-        f->phase = APPROACH;
-        printf("Flight %s moving to APPROACH phase...\n", f->id);
-        setApproachSpeed(f);
-        f->altitude = rand() % 10000 + 1500;
-        f->position = rand() % 901;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "NORTH") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x += 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.47f, 0.47f});
-        
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = LANDING;
-        printf("Flight %s starting LANDING phase...\n", f->id);
-        setLandingSpeed(f);
-        f->altitude = rand() % 4500;
-        f->position = rand() % 300;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "NORTH") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x += 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.43f, 0.43f});
-        
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = TAXI;
-        printf("Flight %s taxiing to gate...\n", f->id);
-        setTaxiSpeed(f);
-        f->altitude = rand() % 2;
-        f->position = rand() % 70;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "NORTH") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x += 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.39f, 0.39f});
-        
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = AT_GATE;
-        printf("Flight %s parked at gate.\n", f->id);
-        setInitialSpeedForGate(f);
-        f->altitude = rand() % 2;
-        f->position = rand() % 70;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "NORTH") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x += 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.36f, 0.36f});
-        
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-    } else {
-        f->phase = AT_GATE;
-        printf("Flight %s starting at gate (preparing for departure).\n", f->id);
-        setInitialSpeedForGate(f);
-        f->altitude = 0;
-        f->position = rand() % 70;
-        initializeFlightPosition(f);
-        const char* dir = getDirectionString(f->direction);
-        if(strcmp(dir, "EAST") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x -= 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.36f, 0.36f});
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = TAXI;
-        printf("Flight %s taxiing to runway...\n", f->id);
-        setTaxiSpeed(f);
-        f->altitude = 0;
-        f->position = rand() % 70;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "EAST") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x -= 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.39f, 0.39f});
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = TAKEOFF_ROLL;
-        printf("Flight %s starting takeoff roll...\n", f->id);
-        transitionToTakeoffRoll(f);
-        f->altitude = rand() % 150;
-        f->position = rand() % 250;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "EAST") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x -= 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.43f, 0.43f});
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = CLIMB;
-        printf("Flight %s climbing after takeoff...\n", f->id);
-        setClimbSpeed(f);
-        f->altitude = rand() % 30101 + 900;
-        f->position = rand() % 851 + 50;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "EAST") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x -= 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.47f, 0.47f});
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-
-        f->phase = CRUISE;
-        printf("Flight %s cruising at safe altitude...\n", f->id);
-        transitionToCruise(f);
-        f->altitude = rand() % 20001 + 25000;
-        f->position = rand() % 1101 + 50;
-        initializeFlightPosition(f);
-        if(strcmp(dir, "EAST") == 0)
-        {
-              sfSprite_setRotation(f->sprite, 180.0f);
-              f->x += 10;
-        }
-        else
-        {
-              sfSprite_setRotation(f->sprite, 0);
-              f->x -= 10;
-        }
-        sfSprite_setScale(f->sprite, (sfVector2f){0.49f, 0.49f});
-        elapsedTime = 0.0f;
-        while (elapsedTime < phaseDuration && simulationRunning) {
-            float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
-            elapsedTime += deltaTime;
-            pthread_mutex_lock(&flightDataMutex);
-            updateFlightPosition(f, deltaTime);
-            checkForViolations(f, violation_msg, sizeof(violation_msg));
-            pthread_mutex_unlock(&flightDataMutex);
-            usleep(16667);
-        }
-    }
-
-    if (selectedLock != NULL) {
-        pthread_mutex_unlock(selectedLock);
-        printf("[RELEASED] %s runway is now available\n", getRunwayString(f->assignedRunway));
-        sfSprite_destroy(f->sprite);
-        f->sprite = NULL;
-    }
-    sfClock_destroy(clock);
-    printf("Flight %s completed simulation at %s", f->id, ctime(&startTime));
+    renderTrack.base = flights;
+    return true;
 }
 
-void displayFlightState(Flight* f) {
-    printf("Flight %s | Phase: %s | ", f->id, getPhaseString(f->phase));
-    switch (f->phase) {
-        case HOLDING: printf("[~==~] Holding"); break;
-        case APPROACH: printf("[->-] Approaching"); break;
-        case LANDING: printf("[>-<] Landing"); break;
-        case TAXI: printf("[==>] Moving on ground"); break;
-        case AT_GATE: printf("[||] Parked"); break;
-        case TAKEOFF_ROLL: printf("[=>] Accelerating"); break;
-        case CLIMB: printf("[/^\\] Ascending"); break;
-        case CRUISE: printf("[~~~] Cruising"); break;
-        default: printf("[?] Unknown"); break;
-    }
-    printf("\n");
+RenderSample* renderSampleOf(const Flight* f) {
+    RenderTrack* r = &renderTrack;
+    if (!r->samples || f < r->base || f >= r->base + MAX_FLIGHTS) return NULL;
+    return &r->samples[f - r->base];
 }
 
-void displayActiveViolations(Flight* flights, int flightCount) {
-    printf("\033[92m");
-    int activeViolations = 0;
-    printf("\n===== AirControlX Dashboard =====\n");
-    printf("Time: %d seconds\n", getCurrentSimulationTime());
-    printf("--------------------------------\n");
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].avnStatus == ACTIVE || flights[i].avnCount > 0) {
-            activeViolations++;
-        }
-    }
-    printf("Number of Active Violations: %d\n", activeViolations);
-    printf("--------------------------------\n");
-    printf("Aircraft with Active Violations:\n");
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].avnStatus == ACTIVE || flights[i].avnCount > 0) {
-            printf("Flight %s | Airline: %s | Violations: %d | Status: %s\n",
-                   flights[i].id, getAirlineName(flights[i].airlineId),
-                   flights[i].avnCount, flights[i].avnStatus == ACTIVE ? "ACTIVE" : "INACTIVE");
-            if (check_speedViolation(&flights[i])) {
-                printf("  - Speed Violation: %d km/h (Safe: %d+)\n",
-                       flights[i].speed, getMinAllowedSpeed(flights[i].phase));
-            }
-            if (check_altitudeViolation(&flights[i])) {
-                printf("  - Altitude Violation: %d ft (Safe: %d)\n",
-                       flights[i].altitude, getSafeAltitudeForPhase(flights[i].phase));
-            }
-            if (check_positionViolation(&flights[i])) {
-                PositionRange range = getSafePositionRangeForPhase(flights[i].phase);
-                printf("  - Position Violation: %d (Safe: %d-%d)\n",
-                       flights[i].position, range.min, range.max);
-            }
-            if (isRunwayViolation(&flights[i])) {
-                printf("  - Runway Violation: %s (Direction: %s)\n",
-                       getRunwayString(flights[i].assignedRunway), getDirectionString(flights[i].direction));
-            }
-        }
-    }
-    printf("--------------------------------\n");
+void publishFlightPosition(const Flight* f, double now) {
+    RenderSample* s = renderSampleOf(f);
+    if (!s) return;
+    s->fromX = s->toX;
+    s->fromY = s->toY;
+    s->fromTime = s->toTime;
+    s->toX = f->x;
+    s->toY = f->y;
+    s->toTime = now;
+}
+
+// A jump (a new phase starts somewhere else) is shown at once instead of
+// being swept across the screen.
+void snapFlightPosition(const Flight* f, double now) {
+    RenderSample* s = renderSampleOf(f);
+    if (!s) return;
+    s->fromX = s->toX = f->x;
+    s->fromY = s->toY = f->y;
+    s->fromTime = s->toTime = now;
+    s->published = true;
+}
+
+// Where the display shows f at time now; flights no tick has published yet
+// (or ever will, as in a replay) are shown where they are.
+sfVector2f displayedFlightPosition(const Flight* f, double now) {
+    const RenderSample* s = renderSampleOf(f);
+    if (!s || !s->published) return (sfVector2f){f->x, f->y};
+    double span = s->toTime - s->fromTime;
+    float t = span > 0 ? (float)((now - s->toTime) / span) : 1.0f;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return (sfVector2f){s->fromX + (s->toX - s->fromX) * t, s->fromY + (s->toY - s->fromY) * t};
+}
+
+// Conflict probe (--probe horizon=S[,separation=PX][,vertical=FT]). Each
+// flight in the air carries a prediction of where it is going: straight for
+// its phase target at its current speed, then holding there, climbing or
+// descending at its phase's rate all along -- the model the kinematics above
+// fly. A tick only rebuilds a flight's prediction once the flight has left
+// it (new phase, speed or target, or drift beyond PROBE_DRIFT), and then only
+// tests it against flights whose swept paths share a grid cell with its own.
+// Predicted losses of separation and altitude envelope exits are logged once
+// they come within the horizon.
+#define DEFAULT_PROBE_HORIZON 120.0
+#define DEFAULT_PROBE_SEPARATION 20.0f
+#define DEFAULT_PROBE_VERTICAL 1000.0f
+#define PROBE_CELL_SIZE 64.0f
+#define PROBE_GRID_COLUMNS 16
+#define PROBE_GRID_ROWS 12
+#define PROBE_DRIFT 10.0f
+#define PROBE_ALTITUDE_DRIFT 50.0f
+
+typedef struct {
+    bool tracked;
+    bool envelopeReported;
+    bool partnerReported;     // scratch while the conflicts of a flight are rebuilt
+    uint8_t phase;
+    int speed;
+    int trackedSlot;
+    uint32_t visited;         // scratch: last rebuild that tested this flight
+    // The prediction: at start the flight is at (x, y, altitude), it moves at
+    // velocity until arrival and changes altitude at climbRate until groundAt.
+    double start;
+    float x;
+    float y;
+    float targetX;
+    float targetY;
+    float velocityX;
+    float velocityY;
+    double arrival;
+    float altitude;
+    float climbRate;
+    double groundAt;
+    double envelopeAt;        // when altitude leaves the phase envelope, INFINITY if never
+    int envelopeLimit;
+    float boxX0, boxY0, boxX1, boxY1;     // swept path, padded by half the separation
+    int cellX0, cellY0, cellX1, cellY1;   // the same in grid cells
+} ProbeEntry;
+
+typedef struct {
+    int a;
+    int b;
+    double at;
+    bool reported;
+} ProbeConflict;
+
+typedef struct {
+    int* flights;
+    int count;
+    int capacity;
+} ProbeCell;
+
+typedef struct {
+    bool enabled;
+    double horizon;
+    float separation;
+    float vertical;
+    Flight* base;
+    ProbeEntry* entries;      // by flight slot, like the violation index
+    int* tracked;
+    int trackedCount;
+    int* scratch;
+    ProbeCell cells[PROBE_GRID_ROWS][PROBE_GRID_COLUMNS];
+    ProbeConflict* conflicts;
+    int conflictCount;
+    int conflictCapacity;
+    uint32_t rebuilds;
+} ConflictProbe;
+
+ConflictProbe probe = {
+    .horizon = DEFAULT_PROBE_HORIZON, .separation = DEFAULT_PROBE_SEPARATION, .vertical = DEFAULT_PROBE_VERTICAL
+};
+pthread_mutex_t probeLock = PTHREAD_MUTEX_INITIALIZER;
+_Atomic double probeNextAlert = INFINITY;   // earliest alert not yet logged
+
+bool parseProbeSpec(const char* spec) {
+    char buffer[128];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        if (!eq) return false;
+        *eq = '\0';
+        const char* value = eq + 1;
+        if (strcmp(item, "horizon") == 0) probe.horizon = atof(value);
+        else if (strcmp(item, "separation") == 0) probe.separation = atof(value);
+        else if (strcmp(item, "vertical") == 0) probe.vertical = atof(value);
+        else return false;
+    }
+    probe.enabled = true;
+    return probe.horizon > 0 && probe.separation > 0 && probe.vertical >= 0;
+}
+
+bool conflictProbeInit(Flight* flights) {
+    probe.entries = calloc(MAX_FLIGHTS, sizeof(ProbeEntry));
+    probe.tracked = malloc(sizeof(int) * MAX_FLIGHTS);
+    probe.scratch = malloc(sizeof(int) * MAX_FLIGHTS);
+    if (!probe.entries || !probe.tracked || !probe.scratch) {
+        perror("Failed to allocate conflict probe");
+        return false;
+    }
+    probe.base = flights;
+    return true;
+}
+
+// Grid cell of a coordinate; anything off the grid falls into the edge cells.
+int probeCellOf(float v, int cells) {
+    float c = floorf(v / PROBE_CELL_SIZE);
+    if (!(c > 0)) return 0;
+    return c >= cells ? cells - 1 : (int)c;
+}
+
+void probeState(const ProbeEntry* e, double t, double* x, double* y, double* altitude) {
+    double moving = (t < e->arrival ? t : e->arrival) - e->start;
+    double climbing = (t < e->groundAt ? t : e->groundAt) - e->start;
+    if (moving < 0) moving = 0;
+    if (climbing < 0) climbing = 0;
+    *x = e->x + e->velocityX * moving;
+    *y = e->y + e->velocityY * moving;
+    *altitude = e->altitude + e->climbRate * climbing;
+}
+
+void predictFlight(ProbeEntry* e, const Flight* f, double now) {
+    const PhaseKinematics* k = phaseKinematicsFor(f->phase);
+    float dx = f->targetX - f->x;
+    float dy = f->targetY - f->y;
+    float distance = sqrtf(dx * dx + dy * dy);
+    float groundSpeed = f->speed * k->pixelsPerKmh;
+    e->phase = (uint8_t)f->phase;
+    e->speed = f->speed;
+    e->start = now;
+    e->x = f->x;
+    e->y = f->y;
+    e->targetX = f->targetX;
+    e->targetY = f->targetY;
+    e->velocityX = distance > 0 && groundSpeed > 0 ? dx / distance * groundSpeed : 0;
+    e->velocityY = distance > 0 && groundSpeed > 0 ? dy / distance * groundSpeed : 0;
+    e->arrival = distance > 0 && groundSpeed > 0 ? now + distance / groundSpeed : now;
+    e->altitude = f->altitude + f->altitudeCarry;
+    e->climbRate = k->climbRate;
+    e->groundAt = e->climbRate < 0 ? now + e->altitude / -e->climbRate : INFINITY;
+    // Only exits ahead count; a flight already outside its envelope is the
+    // present-state checks' business.
+    AltitudeRange envelope = getAltitudeEnvelopeForPhase(f->phase);
+    e->envelopeAt = INFINITY;
+    if (e->altitude >= envelope.min && e->altitude <= envelope.max) {
+        if (e->climbRate > 0 && envelope.max < INT_MAX) {
+            e->envelopeAt = now + (envelope.max - e->altitude) / e->climbRate;
+            e->envelopeLimit = envelope.max;
+        } else if (e->climbRate < 0 && envelope.min > 0) {
+            e->envelopeAt = now + (e->altitude - envelope.min) / -e->climbRate;
+            e->envelopeLimit = envelope.min;
+        }
+    }
+    float margin = probe.separation / 2;
+    e->boxX0 = (dx < 0 ? f->targetX : f->x) - margin;
+    e->boxX1 = (dx < 0 ? f->x : f->targetX) + margin;
+    e->boxY0 = (dy < 0 ? f->targetY : f->y) - margin;
+    e->boxY1 = (dy < 0 ? f->y : f->targetY) + margin;
+    e->cellX0 = probeCellOf(e->boxX0, PROBE_GRID_COLUMNS);
+    e->cellX1 = probeCellOf(e->boxX1, PROBE_GRID_COLUMNS);
+    e->cellY0 = probeCellOf(e->boxY0, PROBE_GRID_ROWS);
+    e->cellY1 = probeCellOf(e->boxY1, PROBE_GRID_ROWS);
+}
+
+// Whether the flight has strayed from its prediction; only its own thread
+// calls this, and only its own thread rewrites the prediction.
+bool probeStale(const ProbeEntry* e, const Flight* f, double now) {
+    if (!e->tracked || e->phase != f->phase || e->speed != f->speed || e->targetX != f->targetX ||
+        e->targetY != f->targetY) return true;
+    double x, y, altitude;
+    probeState(e, now, &x, &y, &altitude);
+    return fabs(x - f->x) > PROBE_DRIFT || fabs(y - f->y) > PROBE_DRIFT ||
+           fabs(altitude - (f->altitude + f->altitudeCarry)) > PROBE_ALTITUDE_DRIFT;
+}
+
+// Earliest time from `from` on at which a and b are inside both separation
+// minima at once, or INFINITY. Between breakpoints (arrivals and touchdowns)
+// both predictions are linear, so each stretch is a quadratic in time for the
+// horizontal distance and a linear one for the vertical.
+double probeSeparationLoss(const ProbeEntry* a, const ProbeEntry* b, double from) {
+    if (a->climbRate == 0 && b->climbRate == 0 && fabsf(a->altitude - b->altitude) >= probe.vertical) return INFINITY;
+    double breaks[5] = { a->arrival, b->arrival, a->groundAt, b->groundAt, INFINITY };
+    for (int k = 1; k < 4; k++) {
+        for (int j = k; j > 0 && breaks[j] < breaks[j - 1]; j--) {
+            double t = breaks[j];
+            breaks[j] = breaks[j - 1];
+            breaks[j - 1] = t;
+        }
+    }
+    double t0 = from;
+    for (int k = 0; k < 5; k++) {
+        if (breaks[k] <= t0) continue;
+        double t1 = breaks[k];
+        double ax, ay, aAltitude, bx, by, bAltitude;
+        probeState(a, t0, &ax, &ay, &aAltitude);
+        probeState(b, t0, &bx, &by, &bAltitude);
+        double px = ax - bx, py = ay - by, dz = aAltitude - bAltitude;
+        double vx = (t0 < a->arrival ? a->velocityX : 0) - (t0 < b->arrival ? b->velocityX : 0);
+        double vy = (t0 < a->arrival ? a->velocityY : 0) - (t0 < b->arrival ? b->velocityY : 0);
+        double w = (t0 < a->groundAt ? a->climbRate : 0) - (t0 < b->groundAt ? b->climbRate : 0);
+        double lo = 0, hi = t1 - t0;
+        double qa = vx * vx + vy * vy, qb = 2 * (px * vx + py * vy);
+        double qc = px * px + py * py - (double)probe.separation * probe.separation;
+        if (qa < 1e-12) {
+            if (qc >= 0) hi = -1;
+        } else {
+            double disc = qb * qb - 4 * qa * qc;
+            if (disc <= 0) hi = -1;
+            else {
+                double root = sqrt(disc);
+                lo = fmax(lo, (-qb - root) / (2 * qa));
+                hi = fmin(hi, (-qb + root) / (2 * qa));
+            }
+        }
+        if (fabs(w) < 1e-9) {
+            if (fabs(dz) >= probe.vertical) hi = -1;
+        } else {
+            double v0 = (-probe.vertical - dz) / w, v1 = (probe.vertical - dz) / w;
+            lo = fmax(lo, fmin(v0, v1));
+            hi = fmin(hi, fmax(v0, v1));
+        }
+        if (lo < hi) return t0 + lo;
+        t0 = t1;
+        if (isinf(t0)) break;
+    }
+    return INFINITY;
+}
+
+void indexProbeEntry(int i) {
+    ProbeEntry* e = &probe.entries[i];
+    for (int cy = e->cellY0; cy <= e->cellY1; cy++) {
+        for (int cx = e->cellX0; cx <= e->cellX1; cx++) {
+            ProbeCell* c = &probe.cells[cy][cx];
+            if (c->count == c->capacity) {
+                int capacity = c->capacity ? c->capacity * 2 : 16;
+                int* grown = realloc(c->flights, sizeof(int) * capacity);
+                if (!grown) {
+                    perror("Failed to grow conflict probe cell");
+                    exit(1);
+                }
+                c->flights = grown;
+                c->capacity = capacity;
+            }
+            c->flights[c->count++] = i;
+        }
+    }
+}
+
+void unindexProbeEntry(int i) {
+    ProbeEntry* e = &probe.entries[i];
+    for (int cy = e->cellY0; cy <= e->cellY1; cy++) {
+        for (int cx = e->cellX0; cx <= e->cellX1; cx++) {
+            ProbeCell* c = &probe.cells[cy][cx];
+            for (int n = 0; n < c->count; n++) {
+                if (c->flights[n] == i) {
+                    c->flights[n] = c->flights[--c->count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Drops every conflict involving flight i; partners whose conflict had
+// already been logged are marked and listed in probe.scratch.
+int dropProbeConflicts(int i) {
+    int marked = 0;
+    for (int n = 0; n < probe.conflictCount;) {
+        ProbeConflict* c = &probe.conflicts[n];
+        if (c->a != i && c->b != i) {
+            n++;
+            continue;
+        }
+        int partner = c->a == i ? c->b : c->a;
+        if (c->reported && !probe.entries[partner].partnerReported) {
+            probe.entries[partner].partnerReported = true;
+            probe.scratch[marked++] = partner;
+        }
+        *c = probe.conflicts[--probe.conflictCount];
+    }
+    return marked;
+}
+
+void addProbeConflict(int a, int b, double at, bool reported) {
+    if (probe.conflictCount == probe.conflictCapacity) {
+        int capacity = probe.conflictCapacity ? probe.conflictCapacity * 2 : 256;
+        ProbeConflict* grown = realloc(probe.conflicts, sizeof(ProbeConflict) * capacity);
+        if (!grown) {
+            perror("Failed to grow conflict list");
+            exit(1);
+        }
+        probe.conflicts = grown;
+        probe.conflictCapacity = capacity;
+    }
+    probe.conflicts[probe.conflictCount++] = (ProbeConflict){a, b, at, reported};
+    if (!reported && at < probeNextAlert) probeNextAlert = at;
+}
+
+// Caller holds probeLock.
+void reprobeFlight(int i, const Flight* f, double now) {
+    ProbeEntry* e = &probe.entries[i];
+    bool envelopeReported = e->tracked && e->phase == f->phase && e->envelopeReported;
+    if (e->tracked) {
+        unindexProbeEntry(i);
+    } else {
+        e->trackedSlot = probe.trackedCount;
+        probe.tracked[probe.trackedCount++] = i;
+    }
+    int marked = dropProbeConflicts(i);
+    predictFlight(e, f, now);
+    e->tracked = true;
+    e->envelopeReported = envelopeReported;
+    if (!envelopeReported && e->envelopeAt < probeNextAlert) probeNextAlert = e->envelopeAt;
+    indexProbeEntry(i);
+    uint32_t rebuild = ++probe.rebuilds;
+    e->visited = rebuild;
+    for (int cy = e->cellY0; cy <= e->cellY1; cy++) {
+        for (int cx = e->cellX0; cx <= e->cellX1; cx++) {
+            ProbeCell* c = &probe.cells[cy][cx];
+            for (int n = 0; n < c->count; n++) {
+                ProbeEntry* other = &probe.entries[c->flights[n]];
+                if (other->visited == rebuild) continue;
+                other->visited = rebuild;
+                if (other->boxX0 > e->boxX1 || other->boxX1 < e->boxX0 || other->boxY0 > e->boxY1 ||
+                    other->boxY1 < e->boxY0) continue;
+                double at = probeSeparationLoss(e, other, now);
+                if (at < INFINITY) addProbeConflict(i, c->flights[n], at, other->partnerReported);
+            }
+        }
+    }
+    for (int n = 0; n < marked; n++) probe.entries[probe.scratch[n]].partnerReported = false;
+}
+
+// Logs every alert that has come within the horizon; caller holds probeLock.
+void reportProbeAlerts(double now) {
+    double next = INFINITY;
+    for (int n = 0; n < probe.conflictCount; n++) {
+        ProbeConflict* c = &probe.conflicts[n];
+        if (c->reported) continue;
+        if (c->at > now + probe.horizon) {
+            if (c->at < next) next = c->at;
+            continue;
+        }
+        c->reported = true;
+        countEvent(COUNTER_PREDICTED_CONFLICTS);
+        if (LOG_WARN >= logLevel) {
+            // The record holds 19 characters, enough for "ARR001/DEP002".
+            char pair[48];
+            snprintf(pair, sizeof(pair), "%s/%s", probe.base[c->a].id, probe.base[c->b].id);
+            logEvent(LOG_WARN, EV_CONFLICT_PREDICTED, pair, (int)((c->at - now) * 10), 0, 0, 0);
+        }
+    }
+    for (int n = 0; n < probe.trackedCount; n++) {
+        ProbeEntry* e = &probe.entries[probe.tracked[n]];
+        if (e->envelopeReported || e->envelopeAt == INFINITY) continue;
+        if (e->envelopeAt > now + probe.horizon) {
+            if (e->envelopeAt < next) next = e->envelopeAt;
+            continue;
+        }
+        e->envelopeReported = true;
+        countEvent(COUNTER_PREDICTED_ENVELOPE_EXITS);
+        LOG_FLIGHT(LOG_WARN, EV_ENVELOPE_PREDICTED, &probe.base[probe.tracked[n]], e->phase,
+                   (int)((e->envelopeAt - now) * 10), e->envelopeLimit, 0);
+    }
+    probeNextAlert = next;
+}
+
+// Called from the tick of the flight's own lifecycle.
+void probeFlight(Flight* f, double now) {
+    if (!probe.enabled || f < probe.base || f >= probe.base + MAX_FLIGHTS) return;
+    int i = (int)(f - probe.base);
+    bool stale = probeStale(&probe.entries[i], f, now);
+    if (!stale && now + probe.horizon < probeNextAlert) return;
+    pthread_mutex_lock(&probeLock);
+    if (stale) reprobeFlight(i, f, now);
+    if (now + probe.horizon >= probeNextAlert) reportProbeAlerts(now);
+    pthread_mutex_unlock(&probeLock);
+}
+
+void probeForget(Flight* f) {
+    if (!probe.enabled || f < probe.base || f >= probe.base + MAX_FLIGHTS) return;
+    int i = (int)(f - probe.base);
+    ProbeEntry* e = &probe.entries[i];
+    pthread_mutex_lock(&probeLock);
+    if (e->tracked) {
+        unindexProbeEntry(i);
+        int marked = dropProbeConflicts(i);
+        for (int n = 0; n < marked; n++) probe.entries[probe.scratch[n]].partnerReported = false;
+        int last = probe.tracked[--probe.trackedCount];
+        probe.tracked[e->trackedSlot] = last;
+        probe.entries[last].trackedSlot = e->trackedSlot;
+        e->tracked = false;
+    }
+    pthread_mutex_unlock(&probeLock);
+}
+
+// Forgets every flight when the store is cleared for a new batch.
+void clearConflictProbe() {
+    if (!probe.enabled || !probe.base) return;
+    pthread_mutex_lock(&probeLock);
+    for (int n = 0; n < probe.trackedCount; n++) probe.entries[probe.tracked[n]].tracked = false;
+    probe.trackedCount = 0;
+    for (int cy = 0; cy < PROBE_GRID_ROWS; cy++) {
+        for (int cx = 0; cx < PROBE_GRID_COLUMNS; cx++) probe.cells[cy][cx].count = 0;
+    }
+    probe.conflictCount = 0;
+    probeNextAlert = INFINITY;
+    pthread_mutex_unlock(&probeLock);
+}
+
+#define PHASE_DURATION_SECONDS 2.0
+#define LIFECYCLE_TICK_SECONDS (1.0 / 60.0)
+#define MAX_LIFECYCLE_WORKERS 8
+#define LIFECYCLE_DONE -1.0
+#define LIFECYCLE_PARKED -2.0
+
+// Lookahead forks and replica runs drive lifecycles on a virtual clock that
+// jumps straight to the next wake-up instead of sleeping.
+bool virtualClock = false;
+double virtualNow = 0;
+
+double monotonicSeconds() {
+    if (virtualClock) return virtualNow;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int randomInRange(RngStream* r, int base, int span) {
+    return span > 0 ? base + rngBelow(r, span) : base;
+}
+
+// One entry per phase of a flight's lifecycle; the arrival and departure
+// sequences below replace the hand-unrolled loops of RealTimeSimulation.
+typedef struct {
+    FlightPhase phase;
+    const char* announce;
+    void (*setSpeed)(Flight*);
+    int altitudeBase;
+    int altitudeSpan;
+    int positionBase;
+    int positionSpan;
+    float scale;
+    bool shiftX;
+} PhaseStep;
+
+const PhaseStep arrivalPlan[] = {
+    {HOLDING, "entering HOLDING phase...", setHoldingSpeed, 8000, 9001, 200, 601, 0.48f, false},
+    {APPROACH, "moving to APPROACH phase...", setApproachSpeed, 1500, 10000, 0, 901, 0.47f, true},
+    {LANDING, "starting LANDING phase...", setLandingSpeed, 0, 4500, 0, 300, 0.43f, true},
+    {TAXI, "taxiing to gate...", setTaxiSpeed, 0, 2, 0, 70, 0.39f, true},
+    {AT_GATE, "parked at gate.", setInitialSpeedForGate, 0, 2, 0, 70, 0.36f, true}
+};
+
+const PhaseStep departurePlan[] = {
+    {AT_GATE, "starting at gate (preparing for departure).", setInitialSpeedForGate, 0, 0, 0, 70, 0.36f, true},
+    {TAXI, "taxiing to runway...", setTaxiSpeed, 0, 0, 0, 70, 0.39f, true},
+    {TAKEOFF_ROLL, "starting takeoff roll...", transitionToTakeoffRoll, 0, 150, 0, 250, 0.43f, true},
+    {CLIMB, "climbing after takeoff...", setClimbSpeed, 900, 30101, 50, 851, 0.47f, true},
+    {CRUISE, "cruising at safe altitude...", transitionToCruise, 25000, 20001, 50, 1101, 0.49f, true}
+};
+
+#define ARRIVAL_PLAN_LENGTH (int)(sizeof(arrivalPlan) / sizeof(arrivalPlan[0]))
+#define DEPARTURE_PLAN_LENGTH (int)(sizeof(departurePlan) / sizeof(departurePlan[0]))
+
+// Ground resources. Gates and taxiway segments are booked as time intervals
+// on the lifecycle clock. Each resource keeps its bookings in an interval
+// tree -- a treap ordered by start and augmented with the latest end in each
+// subtree -- so a conflict query costs O(log n) in the bookings it holds.
+#define MAX_GROUND_RESOURCES 64
+#define DEFAULT_GATES 8
+#define DEFAULT_TAXIWAYS 2
+#define DEFAULT_GATE_TURNAROUND 10.0
+
+typedef enum { GROUND_GATE, GROUND_TAXIWAY, GROUND_KINDS } GroundKind;
+
+typedef struct GroundBooking {
+    double start;
+    double end;
+    double maxEnd;
+    uint64_t priority;
+    struct GroundBooking* left;
+    struct GroundBooking* right;
+} GroundBooking;
+
+typedef struct {
+    GroundBooking* root;
+    int bookings;
+} GroundResource;
+
+typedef struct {
+    GroundResource resources[MAX_GROUND_RESOURCES];
+    int count;
+    uint64_t priorityState;
+    pthread_mutex_t lock;
+} GroundPool;
+
+// A lifecycle's latest booking of each kind; resource is -1 when it has none.
+typedef struct {
+    int resource;
+    double start;
+    double end;
+} GroundHold;
+
+GroundPool groundPools[GROUND_KINDS] = {
+    { .count = DEFAULT_GATES, .lock = PTHREAD_MUTEX_INITIALIZER },
+    { .count = DEFAULT_TAXIWAYS, .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+double gateTurnaroundSeconds = DEFAULT_GATE_TURNAROUND;
+
+const char* getGroundKindString(GroundKind kind) {
+    return kind == GROUND_GATE ? "gate" : "taxiway";
+}
+
+// Parses "gates=8,taxiways=2,turnaround=10". Unspecified keys keep defaults.
+bool parseGroundSpec(const char* spec) {
+    char buffer[128];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        if (!eq) return false;
+        *eq = '\0';
+        const char* value = eq + 1;
+        if (strcmp(item, "gates") == 0) groundPools[GROUND_GATE].count = atoi(value);
+        else if (strcmp(item, "taxiways") == 0) groundPools[GROUND_TAXIWAY].count = atoi(value);
+        else if (strcmp(item, "turnaround") == 0) gateTurnaroundSeconds = atof(value);
+        else return false;
+    }
+    for (int k = 0; k < GROUND_KINDS; k++) {
+        if (groundPools[k].count < 1 || groundPools[k].count > MAX_GROUND_RESOURCES) return false;
+    }
+    return gateTurnaroundSeconds >= 0;
+}
+
+void updateGroundMaxEnd(GroundBooking* n) {
+    n->maxEnd = n->end;
+    if (n->left && n->left->maxEnd > n->maxEnd) n->maxEnd = n->left->maxEnd;
+    if (n->right && n->right->maxEnd > n->maxEnd) n->maxEnd = n->right->maxEnd;
+}
+
+GroundBooking* rotateGroundRight(GroundBooking* n) {
+    GroundBooking* l = n->left;
+    n->left = l->right;
+    l->right = n;
+    updateGroundMaxEnd(n);
+    updateGroundMaxEnd(l);
+    return l;
+}
+
+GroundBooking* rotateGroundLeft(GroundBooking* n) {
+    GroundBooking* r = n->right;
+    n->right = r->left;
+    r->left = n;
+    updateGroundMaxEnd(n);
+    updateGroundMaxEnd(r);
+    return r;
+}
+
+GroundBooking* insertGroundBooking(GroundBooking* n, GroundBooking* b) {
+    if (!n) return b;
+    if (b->start < n->start) {
+        n->left = insertGroundBooking(n->left, b);
+        if (n->left->priority > n->priority) n = rotateGroundRight(n);
+    } else {
+        n->right = insertGroundBooking(n->right, b);
+        if (n->right->priority > n->priority) n = rotateGroundLeft(n);
+    }
+    updateGroundMaxEnd(n);
+    return n;
+}
+
+// Any booking overlapping [start, end), or NULL.
+GroundBooking* findGroundOverlap(GroundBooking* n, double start, double end) {
+    while (n) {
+        if (n->start < end && start < n->end) return n;
+        if (n->left && n->left->maxEnd > start) n = n->left;
+        else n = n->right;
+    }
+    return NULL;
+}
+
+int freeGroundBookings(GroundBooking* n) {
+    if (!n) return 0;
+    int freed = 1 + freeGroundBookings(n->left) + freeGroundBookings(n->right);
+    free(n);
+    return freed;
+}
+
+// Drops bookings that ended by now. Bookings on one resource never overlap,
+// so the ended ones are a prefix in start order.
+GroundBooking* pruneGroundBookings(GroundBooking* n, double now, int* removed) {
+    if (!n) return NULL;
+    if (n->end <= now) {
+        GroundBooking* right = n->right;
+        n->right = NULL;
+        *removed += freeGroundBookings(n);
+        return pruneGroundBookings(right, now, removed);
+    }
+    n->left = pruneGroundBookings(n->left, now, removed);
+    updateGroundMaxEnd(n);
+    return n;
+}
+
+// Earliest start at or after from when the resource is free for duration.
+double earliestGroundFit(const GroundResource* r, double from, double duration) {
+    GroundBooking* o;
+    while ((o = findGroundOverlap(r->root, from, from + duration))) from = o->end;
+    return from;
+}
+
+bool addGroundBooking(GroundPool* pool, int resource, double start, double end) {
+    GroundBooking* b = calloc(1, sizeof(GroundBooking));
+    if (!b) return false;
+    b->start = start;
+    b->end = end;
+    b->maxEnd = end;
+    b->priority = splitmix64(&pool->priorityState);
+    pool->resources[resource].root = insertGroundBooking(pool->resources[resource].root, b);
+    pool->resources[resource].bookings++;
+    return true;
+}
+
+// Books the resource of this kind that frees up first for [t, t + duration)
+// with t >= from, and returns t; the hold records what was booked.
+double bookGround(GroundKind kind, double from, double duration, GroundHold* hold) {
+    GroundPool* pool = &groundPools[kind];
+    pthread_mutex_lock(&pool->lock);
+    int best = -1;
+    double bestStart = 0;
+    for (int i = 0; i < pool->count; i++) {
+        GroundResource* r = &pool->resources[i];
+        int removed = 0;
+        r->root = pruneGroundBookings(r->root, from, &removed);
+        r->bookings -= removed;
+        double start = earliestGroundFit(r, from, duration);
+        if (best < 0 || start < bestStart) {
+            best = i;
+            bestStart = start;
+            if (start <= from) break;
+        }
+    }
+    if (!addGroundBooking(pool, best, bestStart, bestStart + duration)) {
+        pthread_mutex_unlock(&pool->lock);
+        hold->resource = -1;
+        return from;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    hold->resource = best;
+    hold->start = bestStart;
+    hold->end = bestStart + duration;
+    return bestStart;
+}
+
+// Re-enters a booking from a restored snapshot.
+void restoreGroundBooking(GroundKind kind, const GroundHold* hold) {
+    GroundPool* pool = &groundPools[kind];
+    if (hold->resource < 0 || hold->resource >= pool->count) return;
+    pthread_mutex_lock(&pool->lock);
+    if (!findGroundOverlap(pool->resources[hold->resource].root, hold->start, hold->end)) {
+        addGroundBooking(pool, hold->resource, hold->start, hold->end);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Empties every resource before a run; bookings from an earlier run are on
+// a clock that no longer applies.
+void resetGround() {
+    for (int k = 0; k < GROUND_KINDS; k++) {
+        GroundPool* pool = &groundPools[k];
+        pthread_mutex_lock(&pool->lock);
+        for (int i = 0; i < pool->count; i++) {
+            freeGroundBookings(pool->resources[i].root);
+            pool->resources[i].root = NULL;
+            pool->resources[i].bookings = 0;
+        }
+        pool->priorityState = scenarioSeed ^ (uint64_t)k;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+const char* getLogLevelString(LogLevel level) {
+    switch (level) {
+        case LOG_TRACE: return "TRACE";
+        case LOG_DEBUG: return "DEBUG";
+        case LOG_INFO: return "INFO";
+        case LOG_WARN: return "WARN";
+        case LOG_ERROR: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+const char* getPhaseAnnouncement(FlightPhase phase, bool departurePlanUsed) {
+    const PhaseStep* plan = departurePlanUsed ? departurePlan : arrivalPlan;
+    int length = departurePlanUsed ? DEPARTURE_PLAN_LENGTH : ARRIVAL_PLAN_LENGTH;
+    for (int i = 0; i < length; i++) {
+        if (plan[i].phase == phase) return plan[i].announce;
+    }
+    return getPhaseString(phase);
+}
+
+void formatLogRecord(const LogRecord* r, char* out, size_t size, bool colour) {
+    const char* red = colour ? "\033[1;31m" : "";
+    const char* yellow = colour ? "\033[1;33m" : "";
+    const char* reset = colour ? "\033[0m" : "";
+    time_t when = (time_t)(r->timestampNs / 1000000000ULL);
+    char stamp[32];
+    switch (r->event) {
+        case EV_FLIGHT_SCHEDULED:
+            snprintf(out, size, "\n[Thread] Flight %s scheduled to start in %d seconds (Priority: %d)\n",
+                     r->flightId, r->args[0], r->args[1]);
+            break;
+        case EV_LIFECYCLE_START:
+            ctime_r(&when, stamp);
+            snprintf(out, size, "\n--- Simulating Flight %s ---\nSimulation Start Time: %s"
+                     "Airline: %s | Type: %s | Direction: %s | Fuel: %d%%\n",
+                     r->flightId, stamp, airlineName(r->args[0]), getFlightTypeString(r->args[1]),
+                     getDirectionString(r->args[2]), r->args[3]);
+            break;
+        case EV_LOW_FUEL:
+            snprintf(out, size, "LOW FUEL EMERGENCY! Flight %s\n", r->flightId);
+            break;
+        case EV_RUNWAY_ASSIGNED:
+            snprintf(out, size, "Assigned Runway: %s\n", getRunwayString(r->args[0]));
+            break;
+        case EV_RUNWAY_LOCKED:
+            snprintf(out, size, "[LOCKED] %s runway in use by flight %s\n", getRunwayString(r->args[0]), r->flightId);
+            break;
+        case EV_RUNWAY_RELEASED:
+            snprintf(out, size, "[RELEASED] %s runway is now available\n", getRunwayString(r->args[0]));
+            break;
+        case EV_PHASE_CHANGE:
+            snprintf(out, size, "Flight %s %s\n", r->flightId, getPhaseAnnouncement(r->args[0], r->args[1]));
+            break;
+        case EV_LIFECYCLE_DONE:
+            ctime_r(&when, stamp);
+            snprintf(out, size, "Flight %s completed simulation at %s", r->flightId, stamp);
+            break;
+        case EV_FAULT:
+            snprintf(out, size, "FAULT DETECTED! Flight %s has ground fault\n", r->flightId);
+            break;
+        case EV_GROUND_WAIT:
+            snprintf(out, size, "Flight %s holding %d ms for %s %d\n", r->flightId, r->args[2],
+                     getGroundKindString(r->args[0]), r->args[1] + 1);
+            break;
+        case EV_AVN_ACTIVATED:
+            snprintf(out, size, "\n!!! AVN ACTIVATED for Flight %s !!!\n", r->flightId);
+            break;
+        case EV_SPEED_VIOLATION:
+            snprintf(out, size, "%s!!!! Speed Violation has Occurred !!!!%s Flight %s | %s | %d km/h\n",
+                     red, reset, r->flightId, getPhaseString(r->args[0]), r->args[1]);
+            break;
+        case EV_POSITION_VIOLATION:
+            snprintf(out, size, "%s!!!! Position Violation has Occurred !!!!%s Flight %s | %s | Position %d\n",
+                     red, reset, r->flightId, getPhaseString(r->args[0]), r->args[1]);
+            break;
+        case EV_ALTITUDE_VIOLATION:
+            snprintf(out, size, "%s!!!! Altitude Violation has Occurred !!!!%s Flight %s | %s | %d ft\n",
+                     red, reset, r->flightId, getPhaseString(r->args[0]), r->args[1]);
+            break;
+        case EV_CONFLICT_PREDICTED:
+            snprintf(out, size, "%s>>>> Predicted Loss of Separation%s Flights %s | in %.1f s\n",
+                     yellow, reset, r->flightId, r->args[0] / 10.0);
+            break;
+        case EV_ENVELOPE_PREDICTED:
+            snprintf(out, size, "%s>>>> Predicted Altitude Violation%s Flight %s | %s | in %.1f s (limit %d ft)\n",
+                     yellow, reset, r->flightId, getPhaseString(r->args[0]), r->args[1] / 10.0, r->args[2]);
+            break;
+        default:
+            snprintf(out, size, "Flight %s | event %d\n", r->flightId, r->event);
+            break;
+    }
+}
+
+void writeLogRecord(FILE* out, const LogRecord* r) {
+    if (logSink == LOG_SINK_BINARY) {
+        fwrite(r, sizeof(LogRecord), 1, out);
+        return;
+    }
+    char line[512];
+    formatLogRecord(r, line, sizeof(line), logSink == LOG_SINK_CONSOLE);
+    if (logSink == LOG_SINK_FILE) {
+        fprintf(out, "[%s] %s", getLogLevelString(r->level), line);
+    } else {
+        fputs(line, out);
+    }
+}
+
+// Merges the per-thread rings by timestamp so console output keeps the
+// order in which events happened across threads.
+int drainLogBuffers(FILE* out) {
+    int drained = 0;
+    while (1) {
+        LogBuffer* oldest = NULL;
+        const LogRecord* oldestRecord = NULL;
+        for (LogBuffer* b = atomic_load(&logBuffers); b; b = b->next) {
+            uint32_t tail = atomic_load_explicit(&b->tail, memory_order_relaxed);
+            if (tail == atomic_load_explicit(&b->head, memory_order_acquire)) continue;
+            const LogRecord* r = &b->records[tail & (LOG_RING_SIZE - 1)];
+            if (!oldestRecord || r->timestampNs < oldestRecord->timestampNs) {
+                oldest = b;
+                oldestRecord = r;
+            }
+        }
+        if (!oldest) break;
+        writeLogRecord(out, oldestRecord);
+        atomic_fetch_add_explicit(&oldest->tail, 1, memory_order_release);
+        drained++;
+    }
+    for (LogBuffer* b = atomic_load(&logBuffers); b; b = b->next) {
+        uint64_t dropped = atomic_exchange_explicit(&b->dropped, 0, memory_order_relaxed);
+        if (dropped > 0 && logSink != LOG_SINK_BINARY) {
+            fprintf(out, "[log] %llu records dropped (buffer full)\n", (unsigned long long)dropped);
+        }
+    }
+    return drained;
+}
+
+void* logSinkThread(void* arg) {
+    (void)arg;
+    FILE* out = stdout;
+    if (logSink == LOG_SINK_FILE) out = fopen("simulation_log.txt", "a");
+    else if (logSink == LOG_SINK_BINARY) out = fopen("simulation_log.bin", "ab");
+    if (!out) {
+        perror("Failed to open log sink");
+        out = stdout;
+        logSink = LOG_SINK_CONSOLE;
+    }
+    while (atomic_load(&logSinkRunning)) {
+        if (drainLogBuffers(out) > 0) fflush(out);
+        else usleep(2000);
+    }
+    drainLogBuffers(out);
+    fflush(out);
+    if (out != stdout) fclose(out);
+    return NULL;
+}
+
+void logInit() {
+    pthread_key_create(&logBufferKey, releaseLogBuffer);
+    atomic_store(&logSinkRunning, true);
+    if (pthread_create(&logSinkThreadId, NULL, logSinkThread, NULL) != 0) {
+        perror("Failed to start log sink");
+        atomic_store(&logSinkRunning, false);
+        logLevel = LOG_OFF;
+    }
+}
+
+// Blocks until every record appended so far has been written by the sink.
+void logFlush() {
+    if (!atomic_load(&logSinkRunning)) return;
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        for (LogBuffer* b = atomic_load(&logBuffers); b; b = b->next) {
+            if (atomic_load(&b->head) != atomic_load(&b->tail)) pending = true;
+        }
+        if (pending) usleep(1000);
+    }
+    fflush(stdout);
+}
+
+void logShutdown() {
+    if (!atomic_load(&logSinkRunning)) return;
+    atomic_store(&logSinkRunning, false);
+    pthread_join(logSinkThreadId, NULL);
+}
+
+typedef enum { LC_SCHEDULED, LC_ACQUIRE_RUNWAY, LC_ENTER_PHASE, LC_IN_PHASE, LC_RELEASE, LC_DONE } LifecycleState;
+
+// Resumable state of one flight. A worker resumes it, it runs until the next
+// timed wait or runway wait, and hands control back to the scheduler.
+struct LifecycleScheduler;
+
+typedef struct FlightLifecycle {
+    Flight* flight;
+    struct LifecycleScheduler* scheduler;
+    const PhaseStep* plan;
+    int planLength;
+    int step;
+    LifecycleState state;
+    int runwayIndex;
+    int serviceRank;      // place in its runway queue; waiters are granted in this order
+    double phaseElapsed;
+    double lastTick;
+    double wakeTime;
+    double readyAt;
+    uint64_t waitStartNs;
+    GroundHold ground[GROUND_KINDS];
+    bool groundBooked;    // the current step's ground resource is booked
+    struct FlightLifecycle* nextWaiter;
+    struct FlightLifecycle* nextHandoff;   // link in a sector inbox
+    uint64_t snapshotEpoch;   // snapshot round in which it last finished a resume
+} FlightLifecycle;
+
+// Aggregate outcome of one run, in scheduler-clock seconds. Lookahead and
+// replica runs compare candidates on it.
+typedef struct {
+    int movements;
+    int emergencies;
+    double totalWait;
+    double emergencyWait;
+    double maxWait;
+    double finishedAt;
+    int runwayMovements[MAX_RUNWAYS];
+    int groundDelays;
+    double groundWait;
+} RunOutcome;
+
+RunOutcome runOutcome;
+double runStartedAt = 0;
+pthread_mutex_t outcomeLock = PTHREAD_MUTEX_INITIALIZER;
+// Optional per-movement wait log, used by replica runs for percentiles.
+double* waitSamples = NULL;
+int waitSampleCount = 0;
+int waitSampleCapacity = 0;
+
+void recordRunwayWait(const Flight* f, int runwayIndex, double wait) {
+    pthread_mutex_lock(&outcomeLock);
+    runOutcome.movements++;
+    if (runwayIndex >= 0) runOutcome.runwayMovements[runwayIndex]++;
+    if (waitSamples && waitSampleCount < waitSampleCapacity) waitSamples[waitSampleCount++] = wait;
+    runOutcome.totalWait += wait;
+    if (f->isEmergency) {
+        runOutcome.emergencies++;
+        runOutcome.emergencyWait += wait;
+    }
+    if (wait > runOutcome.maxWait) runOutcome.maxWait = wait;
+    pthread_mutex_unlock(&outcomeLock);
+}
+
+// Books the taxiway or gate the lifecycle's next step needs and returns when
+// the step can start, later than now when the ground is congested. An
+// arrival keeps its gate for the turnaround after it parks.
+double bookGroundForStep(FlightLifecycle* lc, double now) {
+    FlightPhase phase = lc->plan[lc->step].phase;
+    double duration = PHASE_DURATION_SECONDS + LIFECYCLE_TICK_SECONDS;
+    GroundKind kind;
+    if (phase == TAXI) {
+        kind = GROUND_TAXIWAY;
+    } else if (phase == AT_GATE) {
+        kind = GROUND_GATE;
+        if (lc->plan == arrivalPlan) duration += gateTurnaroundSeconds;
+    } else {
+        return now;
+    }
+    double start = bookGround(kind, now, duration, &lc->ground[kind]);
+    if (start > now) {
+        pthread_mutex_lock(&outcomeLock);
+        runOutcome.groundDelays++;
+        runOutcome.groundWait += start - now;
+        pthread_mutex_unlock(&outcomeLock);
+        countEvent(COUNTER_GROUND_DELAYS);
+        LOG_FLIGHT(LOG_DEBUG, EV_GROUND_WAIT, lc->flight, kind, lc->ground[kind].resource,
+                   (int)((start - now) * 1000), 0);
+    }
+    return start;
+}
+
+// Runway ownership is handed directly from the releasing flight to the next
+// waiter, so a waiting lifecycle is parked instead of blocking a thread.
+typedef struct {
+    FlightLifecycle* owner;
+    FlightLifecycle* waitHead;
+    FlightLifecycle* waitTail;
+} RunwaySlot;
+
+RunwaySlot runwaySlots[MAX_RUNWAYS];
+
+// Bumped when a snapshot starts copying the store; workers stamp each
+// lifecycle they resume with it, under their scheduler lock.
+_Atomic uint64_t snapshotEpoch = 0;
+
+// Position-independent copy of a lifecycle as stored in a snapshot.
+typedef struct {
+    int32_t flightIndex;
+    int8_t state;
+    int8_t step;
+    int8_t runwayIndex;
+    uint8_t flags;
+    int32_t waitRank;     // 1-based place in its runway wait list, 0 when not parked
+    float phaseElapsed;
+    float wakeIn;         // seconds until the scheduler resumes it
+    int8_t groundResource[GROUND_KINDS];   // -1 when nothing is booked
+    float groundStartIn[GROUND_KINDS];
+    float groundEndIn[GROUND_KINDS];
+} SnapshotLifecycle;
+
+#define SNAPSHOT_LC_DEPARTURE 1
+#define SNAPSHOT_LC_OWNS_RUNWAY 2
+#define SNAPSHOT_LC_GROUND_BOOKED 4
+
+// One scheduler per runway, so queues on different runways never contend for
+// the same heap or lock. While paused no worker picks up new work; running
+// counts lifecycles being resumed right now, so paused with running == 0 means
+// every lifecycle is either in a heap, parked on a runway, in a sector inbox
+// or done.
+typedef struct LifecycleScheduler {
+    FlightLifecycle** heap;
+    int heapCount;
+    int pending;
+    int running;
+    bool paused;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    _Atomic(FlightLifecycle*) inbox;   // sector mode: handoffs, newest first
+    atomic_bool sleeping;              // sector mode: worker is waiting on wake
+} LifecycleScheduler;
+
+LifecycleScheduler schedulers[MAX_RUNWAYS];
+int schedulerCount = 0;
+FlightLifecycle* activeLifecycles = NULL;
+int activeLifecycleCount = 0;
+
+void schedulerInit() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    schedulerCount = sectorCount > 0 ? sectorCount : runwayCount;
+    for (int i = 0; i < schedulerCount; i++) {
+        LifecycleScheduler* s = &schedulers[i];
+        pthread_cond_init(&s->wake, &attr);
+        pthread_mutex_init(&s->lock, NULL);
+        if (i < sectorCount) pthread_mutex_init(&sectorDataLocks[i], NULL);
+        s->heap = malloc(sizeof(FlightLifecycle*) * MAX_FLIGHTS);
+        if (!s->heap) {
+            perror("Failed to allocate scheduler");
+            exit(1);
+        }
+        s->heapCount = 0;
+        s->pending = 0;
+        s->running = 0;
+        s->paused = false;
+        atomic_store(&s->inbox, NULL);
+        atomic_store(&s->sleeping, false);
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+void schedulerDestroy() {
+    for (int i = 0; i < schedulerCount; i++) {
+        free(schedulers[i].heap);
+        pthread_cond_destroy(&schedulers[i].wake);
+        pthread_mutex_destroy(&schedulers[i].lock);
+        if (i < sectorCount) pthread_mutex_destroy(&sectorDataLocks[i]);
+    }
+    schedulerCount = 0;
+}
+
+// Airspace sectors (--sectors N). The display's airspace is cut into N
+// horizontal bands and the schedulers become one per band instead of one per
+// runway. Each band is driven by a single thread that owns its heap and
+// writes its flights under its own data lock. A lifecycle whose flight drifts
+// into another band after a tick, or that a runway release elsewhere wakes,
+// is pushed onto that band's lock-free inbox, so no lock shared between
+// sectors sits on the tick path.
+#define AIRSPACE_HEIGHT 600.0f
+
+_Atomic int sectorLifecyclesLeft = 0;
+
+bool sectorsActive() {
+    return sectorCount > 0 && !virtualClock;
+}
+
+int sectorOf(const Flight* f) {
+    int band = (int)(f->y * sectorCount / AIRSPACE_HEIGHT);
+    if (band < 0) return 0;
+    return band >= sectorCount ? sectorCount - 1 : band;
+}
+
+// On the virtual clock every lifecycle shares one scheduler so simulated
+// time advances in a single order.
+LifecycleScheduler* schedulerFor(const Flight* f, Runway r) {
+    if (virtualClock) return &schedulers[0];
+    if (sectorCount > 0) return &schedulers[sectorOf(f)];
+    return &schedulers[isValidRunway(r) ? r : 0];
+}
+
+// Schedulers are always locked in index order.
+void lockAllSchedulers() {
+    for (int i = 0; i < schedulerCount; i++) pthread_mutex_lock(&schedulers[i].lock);
+}
+
+void unlockAllSchedulers() {
+    for (int i = schedulerCount - 1; i >= 0; i--) pthread_mutex_unlock(&schedulers[i].lock);
+}
+
+// Min-heap on wakeTime; caller holds s->lock.
+void heapPush(LifecycleScheduler* s, FlightLifecycle* lc) {
+    int i = s->heapCount++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (s->heap[parent]->wakeTime <= lc->wakeTime) break;
+        s->heap[i] = s->heap[parent];
+        i = parent;
+    }
+    s->heap[i] = lc;
+}
+
+FlightLifecycle* heapPop(LifecycleScheduler* s) {
+    FlightLifecycle* top = s->heap[0];
+    FlightLifecycle* last = s->heap[--s->heapCount];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= s->heapCount) break;
+        if (child + 1 < s->heapCount && s->heap[child + 1]->wakeTime < s->heap[child]->wakeTime) child++;
+        if (last->wakeTime <= s->heap[child]->wakeTime) break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    if (s->heapCount > 0) s->heap[i] = last;
+    return top;
+}
+
+// Lock-free push onto a sector inbox. The worker sets sleeping before its last
+// look at the inbox, so it either sees this lifecycle or gets the signal; the
+// signal is sent without its lock, and a wakeup lost in between costs at most
+// one tick because a sector never sleeps longer than that.
+void sectorHandoff(LifecycleScheduler* target, FlightLifecycle* lc) {
+    lc->nextHandoff = atomic_load(&target->inbox);
+    while (!atomic_compare_exchange_weak(&target->inbox, &lc->nextHandoff, lc));
+    if (atomic_load(&target->sleeping)) pthread_cond_signal(&target->wake);
+}
+
+void schedulerWake(FlightLifecycle* lc, double when) {
+    LifecycleScheduler* s = lc->scheduler;
+    if (sectorsActive()) {
+        lc->wakeTime = when;
+        sectorHandoff(s, lc);
+        return;
+    }
+    pthread_mutex_lock(&s->lock);
+    lc->wakeTime = when;
+    heapPush(s, lc);
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+bool acquireRunway(FlightLifecycle* lc) {
+    RunwaySlot* slot = &runwaySlots[lc->runwayIndex];
+    bool granted = false;
+    pthread_mutex_lock(&runwayLocks[lc->runwayIndex]);
+    if (slot->owner == NULL || slot->owner == lc) {
+        if (slot->owner == NULL) traceFlightEvent(TRACE_LOCK_GRANT, lc->flight, lc->runwayIndex, 0, 0, 0, 0);
+        slot->owner = lc;
+        granted = true;
+    } else {
+        // The wait list follows the planned queue order, so the plan rather
+        // than who reached the runway first decides the next grant.
+        FlightLifecycle** link = &slot->waitHead;
+        while (*link && (*link)->serviceRank <= lc->serviceRank) link = &(*link)->nextWaiter;
+        lc->nextWaiter = *link;
+        *link = lc;
+        if (!lc->nextWaiter) slot->waitTail = lc;
+    }
+    pthread_mutex_unlock(&runwayLocks[lc->runwayIndex]);
+    return granted;
+}
+
+void releaseRunway(FlightLifecycle* lc, double now) {
+    RunwaySlot* slot = &runwaySlots[lc->runwayIndex];
+    pthread_mutex_lock(&runwayLocks[lc->runwayIndex]);
+    traceFlightEvent(TRACE_LOCK_RELEASE, lc->flight, lc->runwayIndex, 0, 0, 0, 0);
+    FlightLifecycle* next = slot->waitHead;
+    if (next) {
+        slot->waitHead = next->nextWaiter;
+        if (!slot->waitHead) slot->waitTail = NULL;
+        traceFlightEvent(TRACE_LOCK_GRANT, next->flight, next->runwayIndex, 0, 0, 0, 0);
+    }
+    slot->owner = next;
+    pthread_mutex_unlock(&runwayLocks[lc->runwayIndex]);
+    if (next) schedulerWake(next, now);
+}
+
+// The lock a lifecycle writes its flight under: its sector's in sector mode,
+// the whole store otherwise.
+void lockLifecycleFlight(FlightLifecycle* lc) {
+    if (sectorsActive()) pthread_mutex_lock(&sectorDataLocks[lc->scheduler - schedulers]);
+    else lockFlightData();
+}
+
+void unlockLifecycleFlight(FlightLifecycle* lc) {
+    if (sectorsActive()) pthread_mutex_unlock(&sectorDataLocks[lc->scheduler - schedulers]);
+    else unlockFlightData();
+}
+
+void beginFlightLifecycle(FlightLifecycle* lc) {
+    Flight* f = lc->flight;
+    LOG_FLIGHT(LOG_INFO, EV_LIFECYCLE_START, f, f->airlineId, f->type, f->direction, f->fuelLevel);
+    if (f->fuelLevel < FUEL_THRESHOLD && !f->isEmergency) {
+        f->isEmergency = true;
+        LOG_FLIGHT(LOG_WARN, EV_LOW_FUEL, f, 0, 0, 0, 0);
+    }
+    // The queues are the plan, whether greedy or picked by lookahead, so a
+    // flight keeps its queued runway and place in line. Only one that has
+    // since become an emergency its runway does not take is moved, to the
+    // front of the line on an emergency runway.
+    Runway planned = f->assignedRunway;
+    if (isValidRunway(planned) && (!f->isEmergency || (runways[planned].flags & RUNWAY_EMERGENCY))) {
+        placeOnRunway(f, planned);
+    } else {
+        f->assignedRunway = assignRunway(f);
+        lc->serviceRank = -1;
+    }
+    LOG_FLIGHT(LOG_INFO, EV_RUNWAY_ASSIGNED, f, f->assignedRunway, 0, 0, 0);
+    traceFlightEvent(TRACE_RUNWAY_ASSIGNED, f, f->assignedRunway, f->isEmergency, 0, 0, 0);
+    lc->runwayIndex = f->assignedRunway;
+    noteFlightChanged(f);
+    bool isArrival = f->direction == NORTH || f->direction == SOUTH;
+    lc->plan = isArrival ? arrivalPlan : departurePlan;
+    lc->planLength = isArrival ? ARRIVAL_PLAN_LENGTH : DEPARTURE_PLAN_LENGTH;
+    lc->step = 0;
+}
+
+void enterPhase(FlightLifecycle* lc, double now) {
+    Flight* f = lc->flight;
+    const PhaseStep* step = &lc->plan[lc->step];
+    lockLifecycleFlight(lc);
+    f->phase = step->phase;
+    step->setSpeed(f);
+    f->altitude = randomInRange(&f->rng, step->altitudeBase, step->altitudeSpan);
+    f->altitudeCarry = 0;
+    f->position = randomInRange(&f->rng, step->positionBase, step->positionSpan);
+    initializeFlightPosition(f);
+    if (step->shiftX) {
+        float shift = (f->isDeparture && f->direction == WEST) ? -10 : 10;
+        f->x += shift;
+        f->targetX += shift;
+    }
+    snapFlightPosition(f, now);
+    if (f->sprite) {
+        sfSprite_setRotation(f->sprite, (f->direction == NORTH || f->direction == EAST) ? 180.0f : 0);
+        sfSprite_setScale(f->sprite, (sfVector2f){step->scale, step->scale});
+    }
+    traceFlightEvent(TRACE_PHASE_ENTERED, f, f->speed, f->altitude, f->position, 0, 0);
+    noteFlightChanged(f);
+    unlockLifecycleFlight(lc);
+    LOG_FLIGHT(LOG_INFO, EV_PHASE_CHANGE, f, step->phase, lc->plan == departurePlan, 0, 0);
+}
+
+void finishFlightLifecycle(FlightLifecycle* lc, double now) {
+    Flight* f = lc->flight;
+    if (lc->runwayIndex >= 0) {
+        releaseRunway(lc, now);
+        LOG_FLIGHT(LOG_DEBUG, EV_RUNWAY_RELEASED, f, f->assignedRunway, 0, 0, 0);
+        lockLifecycleFlight(lc);
+        if (f->sprite) {
+            sfSprite_destroy(f->sprite);
+            f->sprite = NULL;
+        }
+        unlockLifecycleFlight(lc);
+    }
+    probeForget(f);
+    LOG_FLIGHT(LOG_INFO, EV_LIFECYCLE_DONE, f, 0, 0, 0, 0);
+    traceFlightEvent(TRACE_FLIGHT_DONE, f, 0, 0, 0, 0, 0);
+}
+
+// Runs the lifecycle from its current state up to the next wait. Returns the
+// time it wants to be resumed at, LIFECYCLE_PARKED when it is queued behind
+// another flight's runway, or LIFECYCLE_DONE.
+double resumeFlightLifecycle(FlightLifecycle* lc, double now) {
+    char violation_msg[MAX_VIOLATION_MSG];
+    while (1) {
+        switch (lc->state) {
+            case LC_SCHEDULED:
+                beginFlightLifecycle(lc);
+                lc->readyAt = now;
+                lc->waitStartNs = monotonicNs();
+                lc->state = LC_ACQUIRE_RUNWAY;
+                break;
+            case LC_ACQUIRE_RUNWAY:
+                if (lc->runwayIndex >= 0) {
+                    if (!acquireRunway(lc)) {
+                        countEvent(COUNTER_RUNWAY_PARKS);
+                        return LIFECYCLE_PARKED;
+                    }
+                    recordLatency(METRIC_RUNWAY_WAIT, monotonicNs() - lc->waitStartNs);
+                    recordRunwayWait(lc->flight, lc->runwayIndex, now - lc->readyAt);
+                    countEvent(COUNTER_RUNWAY_GRANTS);
+                    LOG_FLIGHT(LOG_DEBUG, EV_RUNWAY_LOCKED, lc->flight, lc->flight->assignedRunway, 0, 0, 0);
+                }
+                checkForFaults(lc->flight);
+                lc->state = LC_ENTER_PHASE;
+                break;
+            case LC_ENTER_PHASE:
+                if (lc->step >= lc->planLength) {
+                    lc->state = LC_RELEASE;
+                    break;
+                }
+                if (!lc->groundBooked) {
+                    lc->groundBooked = true;
+                    double start = bookGroundForStep(lc, now);
+                    if (start > now) return start;
+                }
+                lc->groundBooked = false;
+                enterPhase(lc, now);
+                lc->phaseElapsed = 0;
+                lc->lastTick = now;
+                lc->state = LC_IN_PHASE;
+                break;
+            case LC_IN_PHASE: {
+                if (lc->phaseElapsed >= PHASE_DURATION_SECONDS || !simulationRunning) {
+                    lc->step++;
+                    lc->state = LC_ENTER_PHASE;
+                    break;
+                }
+                countEvent(COUNTER_TICKS);
+                float deltaTime = (float)(now - lc->lastTick);
+                lc->lastTick = now;
+                lc->phaseElapsed += deltaTime;
+                lockLifecycleFlight(lc);
+                updateFlightPosition(lc->flight, deltaTime);
+                publishFlightPosition(lc->flight, now);
+                checkForViolations(lc->flight, violation_msg, sizeof(violation_msg));
+                probeFlight(lc->flight, now);
+                unlockLifecycleFlight(lc);
+                return now + LIFECYCLE_TICK_SECONDS;
+            }
+            case LC_RELEASE:
+                finishFlightLifecycle(lc, now);
+                pthread_mutex_lock(&outcomeLock);
+                if (now - runStartedAt > runOutcome.finishedAt) runOutcome.finishedAt = now - runStartedAt;
+                pthread_mutex_unlock(&outcomeLock);
+                lc->state = LC_DONE;
+                return LIFECYCLE_DONE;
+            case LC_DONE:
+                return LIFECYCLE_DONE;
+        }
+    }
+}
+
+// rank is the flight's place in its runway queue, INT_MAX for one that joins
+// mid-run and so waits behind the planned flights.
+void scheduleFlightLifecycle(FlightLifecycle* lc, Flight* f, int rank, double now, LifecycleScheduler* s) {
+    if (f->priority == 0) {
+        if (f->isEmergency) f->priority = 2;
+        else if (f->isVIP || f->fuelLevel < FUEL_THRESHOLD + 10) f->priority = 1;
+    }
+    LOG_FLIGHT(LOG_INFO, EV_FLIGHT_SCHEDULED, f, f->scheduledTime, f->priority, 0, 0);
+    memset(lc, 0, sizeof(*lc));
+    lc->flight = f;
+    lc->scheduler = s;
+    lc->state = LC_SCHEDULED;
+    lc->runwayIndex = -1;
+    lc->serviceRank = rank;
+    for (int k = 0; k < GROUND_KINDS; k++) lc->ground[k].resource = -1;
+    pthread_mutex_lock(&s->lock);
+    lc->wakeTime = now + f->scheduledTime;
+    heapPush(s, lc);
+    s->pending++;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void* lifecycleWorker(void* arg) {
+    LifecycleScheduler* s = arg;
+    pthread_mutex_lock(&s->lock);
+    while (s->pending > 0) {
+        if (s->paused || s->heapCount == 0) {
+            pthread_cond_wait(&s->wake, &s->lock);
+            continue;
+        }
+        double now = monotonicSeconds();
+        FlightLifecycle* lc = s->heap[0];
+        if (lc->wakeTime > now && virtualClock) {
+            // Nothing is due: jump ahead, but only once no resume in progress
+            // can still schedule something earlier.
+            if (s->running == 0) virtualNow = lc->wakeTime;
+            else pthread_cond_wait(&s->wake, &s->lock);
+            continue;
+        }
+        if (lc->wakeTime > now) {
+            struct timespec until;
+            until.tv_sec = (time_t)lc->wakeTime;
+            until.tv_nsec = (long)((lc->wakeTime - until.tv_sec) * 1e9);
+            pthread_cond_timedwait(&s->wake, &s->lock, &until);
+            continue;
+        }
+        heapPop(s);
+        s->running++;
+        pthread_mutex_unlock(&s->lock);
+        uint64_t tickStart = monotonicNs();
+        double next = resumeFlightLifecycle(lc, now);
+        recordLatency(METRIC_TICK, monotonicNs() - tickStart);
+        pthread_mutex_lock(&s->lock);
+        s->running--;
+        lc->snapshotEpoch = atomic_load_explicit(&snapshotEpoch, memory_order_relaxed);
+        if (s->paused && s->running == 0) pthread_cond_broadcast(&s->wake);
+        if (next == LIFECYCLE_DONE) {
+            s->pending--;
+            if (s->pending == 0) pthread_cond_broadcast(&s->wake);
+        } else if (next != LIFECYCLE_PARKED) {
+            lc->wakeTime = next;
+            heapPush(s, lc);
+            pthread_cond_signal(&s->wake);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+void wakeAllSectors() {
+    for (int i = 0; i < schedulerCount; i++) {
+        pthread_mutex_lock(&schedulers[i].lock);
+        pthread_cond_broadcast(&schedulers[i].wake);
+        pthread_mutex_unlock(&schedulers[i].lock);
+    }
+}
+
+// Takes every handed-off lifecycle into this sector's heap; caller holds s->lock.
+void drainSectorInbox(LifecycleScheduler* s) {
+    FlightLifecycle* lc = atomic_exchange(&s->inbox, NULL);
+    while (lc) {
+        FlightLifecycle* next = lc->nextHandoff;
+        lc->scheduler = s;
+        heapPush(s, lc);
+        lc = next;
+    }
+}
+
+// The one thread that drives a sector. Unlike lifecycleWorker it runs until
+// every lifecycle in the run is done, since flights keep moving in from other
+// sectors after its own heap empties.
+void* sectorWorker(void* arg) {
+    LifecycleScheduler* s = arg;
+    pthread_mutex_lock(&s->lock);
+    while (atomic_load(&sectorLifecyclesLeft) > 0) {
+        if (s->paused) {
+            pthread_cond_wait(&s->wake, &s->lock);
+            continue;
+        }
+        drainSectorInbox(s);
+        double now = monotonicSeconds();
+        if (s->heapCount == 0 || s->heap[0]->wakeTime > now) {
+            atomic_store(&s->sleeping, true);
+            if (atomic_load(&s->inbox) == NULL && atomic_load(&sectorLifecyclesLeft) > 0) {
+                double wakeTime = now + LIFECYCLE_TICK_SECONDS;
+                if (s->heapCount > 0 && s->heap[0]->wakeTime < wakeTime) wakeTime = s->heap[0]->wakeTime;
+                struct timespec until;
+                until.tv_sec = (time_t)wakeTime;
+                until.tv_nsec = (long)((wakeTime - until.tv_sec) * 1e9);
+                pthread_cond_timedwait(&s->wake, &s->lock, &until);
+            }
+            atomic_store(&s->sleeping, false);
+            continue;
+        }
+        FlightLifecycle* lc = heapPop(s);
+        s->running++;
+        pthread_mutex_unlock(&s->lock);
+        uint64_t tickStart = monotonicNs();
+        double next = resumeFlightLifecycle(lc, now);
+        recordLatency(METRIC_TICK, monotonicNs() - tickStart);
+        pthread_mutex_lock(&s->lock);
+        s->running--;
+        lc->snapshotEpoch = atomic_load_explicit(&snapshotEpoch, memory_order_relaxed);
+        // Stamped before the handoff: once lc is in another inbox, only that
+        // sector may write it.
+        LifecycleScheduler* home = next >= 0 ? &schedulers[sectorOf(lc->flight)] : s;
+        if (home != s) {
+            lc->wakeTime = next;
+            lc->scheduler = home;
+            countEvent(COUNTER_SECTOR_HANDOFFS);
+            sectorHandoff(home, lc);
+        }
+        if (s->paused && s->running == 0) pthread_cond_broadcast(&s->wake);
+        if (next == LIFECYCLE_DONE) {
+            if (atomic_fetch_sub(&sectorLifecyclesLeft, 1) == 1) {
+                pthread_mutex_unlock(&s->lock);
+                wakeAllSectors();
+                pthread_mutex_lock(&s->lock);
+            }
+        } else if (next != LIFECYCLE_PARKED && home == s) {
+            lc->wakeTime = next;
+            heapPush(s, lc);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+int lifecycleWorkerCount() {
+    if (virtualClock) return 1;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 2) return 2;
+    return cores > MAX_LIFECYCLE_WORKERS ? MAX_LIFECYCLE_WORKERS : (int)cores;
+}
+
+// Rebuilds a lifecycle from its snapshot copy. Time spent while the
+// simulator was down is not counted against the current phase.
+void restoreFlightLifecycle(FlightLifecycle* lc, const SnapshotLifecycle* s, Flight* flights, double now) {
+    memset(lc, 0, sizeof(*lc));
+    lc->flight = &flights[s->flightIndex];
+    lc->scheduler = schedulerFor(lc->flight, s->runwayIndex >= 0 ? s->runwayIndex : lc->flight->assignedRunway);
+    lc->state = (LifecycleState)s->state;
+    lc->step = s->step;
+    lc->runwayIndex = s->runwayIndex;
+    if (lc->state != LC_SCHEDULED) {
+        bool departure = s->flags & SNAPSHOT_LC_DEPARTURE;
+        lc->plan = departure ? departurePlan : arrivalPlan;
+        lc->planLength = departure ? DEPARTURE_PLAN_LENGTH : ARRIVAL_PLAN_LENGTH;
+    }
+    lc->phaseElapsed = s->phaseElapsed;
+    lc->lastTick = now;
+    lc->readyAt = now;
+    lc->wakeTime = now + s->wakeIn;
+    lc->waitStartNs = monotonicNs();
+    lc->groundBooked = s->flags & SNAPSHOT_LC_GROUND_BOOKED;
+    for (int k = 0; k < GROUND_KINDS; k++) {
+        lc->ground[k] = (GroundHold){ s->groundResource[k], now + s->groundStartIn[k], now + s->groundEndIn[k] };
+        if (s->groundEndIn[k] > 0) restoreGroundBooking((GroundKind)k, &lc->ground[k]);
+    }
+    if ((s->flags & SNAPSHOT_LC_OWNS_RUNWAY) && lc->runwayIndex >= 0) {
+        runwaySlots[lc->runwayIndex].owner = lc;
+    }
+}
+
+// Puts restored lifecycles back where they were: parked ones on their runway
+// wait lists in their original order, the rest in the scheduler heap.
+void requeueRestoredLifecycles(FlightLifecycle* lifecycles, const SnapshotLifecycle* restored, int count) {
+    int* byRank = malloc(sizeof(int) * (count > 0 ? count : 1));
+    for (int r = 0; byRank && r < runwayCount; r++) {
+        int waiting = 0;
+        for (int i = 0; i < count; i++) {
+            if (restored[i].runwayIndex == r && restored[i].waitRank > 0 && restored[i].waitRank <= count) {
+                byRank[restored[i].waitRank - 1] = i;
+                waiting++;
+            }
+        }
+        RunwaySlot* slot = &runwaySlots[r];
+        for (int k = 0; k < waiting; k++) {
+            FlightLifecycle* lc = &lifecycles[byRank[k]];
+            lc->nextWaiter = NULL;
+            if (slot->waitTail) slot->waitTail->nextWaiter = lc;
+            else slot->waitHead = lc;
+            slot->waitTail = lc;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (lifecycles[i].state == LC_DONE) continue;
+        LifecycleScheduler* s = lifecycles[i].scheduler;
+        pthread_mutex_lock(&s->lock);
+        s->pending++;
+        // Without the rank table a parked flight simply retries its runway.
+        if (restored[i].waitRank == 0 || !byRank) heapPush(s, &lifecycles[i]);
+        pthread_mutex_unlock(&s->lock);
+    }
+    free(byRank);
+}
+
+// Builds and queues the lifecycles of a run: the restored ones, or one per
+// flight in the runway queues. spare extra zeroed lifecycles are allocated
+// after them for flights that join mid-run.
+FlightLifecycle* prepareFlightLifecycles(Flight* flights, const SnapshotLifecycle* restored, int restoredCount,
+                                         int spare) {
+    int total = restoredCount;
+    if (!restored) {
+        total = 0;
+        for (int r = 0; r < runwayCount; r++) total += runways[r].queueCount;
+    }
+    FlightLifecycle* lifecycles = calloc(total + spare > 0 ? total + spare : 1, sizeof(FlightLifecycle));
+    if (!lifecycles) {
+        perror("Failed to allocate flight lifecycles");
+        return NULL;
+    }
+    memset(runwaySlots, 0, sizeof(runwaySlots));
+    resetGround();
+    double now = monotonicSeconds();
+    pthread_mutex_lock(&outcomeLock);
+    memset(&runOutcome, 0, sizeof(runOutcome));
+    runStartedAt = now;
+    pthread_mutex_unlock(&outcomeLock);
+    if (restored) {
+        for (int i = 0; i < restoredCount; i++) restoreFlightLifecycle(&lifecycles[i], &restored[i], flights, now);
+        // Flights that still have to reach their runway wait in the order of
+        // the restored queues.
+        int* rankOf = malloc(sizeof(int) * MAX_FLIGHTS);
+        for (int i = 0; rankOf && i < restoredCount; i++) rankOf[restored[i].flightIndex] = INT_MAX;
+        for (int r = 0; rankOf && r < runwayCount; r++) {
+            for (int i = 0; i < runways[r].queueCount; i++) rankOf[runways[r].queue[i] - flights] = i;
+        }
+        for (int i = 0; i < restoredCount; i++) {
+            lifecycles[i].serviceRank = rankOf ? rankOf[restored[i].flightIndex] : INT_MAX;
+        }
+        free(rankOf);
+        requeueRestoredLifecycles(lifecycles, restored, restoredCount);
+    } else {
+        int n = 0;
+        for (int r = 0; r < runwayCount; r++) {
+            for (int i = 0; i < runways[r].queueCount; i++) {
+                scheduleFlightLifecycle(&lifecycles[n++], runways[r].queue[i], i, now,
+                                        schedulerFor(runways[r].queue[i], r));
+            }
+        }
+    }
+    lockAllSchedulers();
+    activeLifecycles = lifecycles;
+    activeLifecycleCount = total;
+    unlockAllSchedulers();
+    return lifecycles;
+}
+
+void releaseFlightLifecycles(FlightLifecycle* lifecycles) {
+    lockAllSchedulers();
+    activeLifecycles = NULL;
+    activeLifecycleCount = 0;
+    unlockAllSchedulers();
+    free(lifecycles);
+}
+
+// Drives every queued flight to completion on a small fixed pool of workers.
+// With restored lifecycles it resumes a snapshotted run instead of starting
+// one from the runway queues.
+void runFlightLifecycles(Flight* flights, const SnapshotLifecycle* restored, int restoredCount) {
+    FlightLifecycle* lifecycles = prepareFlightLifecycles(flights, restored, restoredCount, 0);
+    if (!lifecycles) return;
+
+    if (sectorsActive()) {
+        int left = 0;
+        for (int i = 0; i < schedulerCount; i++) left += schedulers[i].pending;
+        atomic_store(&sectorLifecyclesLeft, left);
+        pthread_t sectorThreads[MAX_SECTORS];
+        int running = 0;
+        for (int i = 1; i < schedulerCount; i++) {
+            if (pthread_create(&sectorThreads[running], NULL, sectorWorker, &schedulers[i]) != 0) {
+                fprintf(stderr, "Failed to create worker for sector %d\n", i);
+                exit(1);
+            }
+            running++;
+        }
+        sectorWorker(&schedulers[0]);
+        for (int i = 0; i < running; i++) pthread_join(sectorThreads[i], NULL);
+        releaseFlightLifecycles(lifecycles);
+        return;
+    }
+
+    // Split the worker pool over the runways that have work, at least one each.
+    int active = 0;
+    for (int i = 0; i < schedulerCount; i++) active += schedulers[i].pending > 0;
+    int perScheduler = active > 0 ? lifecycleWorkerCount() / active : 0;
+    if (perScheduler < 1) perScheduler = 1;
+    pthread_t workers[MAX_RUNWAYS * MAX_LIFECYCLE_WORKERS];
+    int started = 0;
+    bool unserved[MAX_RUNWAYS] = { false };
+    for (int i = 0; i < schedulerCount; i++) {
+        if (schedulers[i].pending == 0) continue;
+        int before = started;
+        for (int w = 0; w < perScheduler && started < MAX_RUNWAYS * MAX_LIFECYCLE_WORKERS; w++) {
+            if (pthread_create(&workers[started], NULL, lifecycleWorker, &schedulers[i]) != 0) {
+                fprintf(stderr, "Failed to create lifecycle worker for %s\n", runways[i].name);
+                continue;
+            }
+            started++;
+        }
+        unserved[i] = started == before;
+    }
+    for (int i = 0; i < schedulerCount; i++) {
+        if (unserved[i]) lifecycleWorker(&schedulers[i]);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    releaseFlightLifecycles(lifecycles);
+}
+
+void displayFlightState(Flight* f) {
+    printf("Flight %s | Phase: %s | ", f->id, getPhaseString(f->phase));
+    switch (f->phase) {
+        case HOLDING: printf("[~==~] Holding"); break;
+        case APPROACH: printf("[->-] Approaching"); break;
+        case LANDING: printf("[>-<] Landing"); break;
+        case TAXI: printf("[==>] Moving on ground"); break;
+        case AT_GATE: printf("[||] Parked"); break;
+        case TAKEOFF_ROLL: printf("[=>] Accelerating"); break;
+        case CLIMB: printf("[/^\\] Ascending"); break;
+        case CRUISE: printf("[~~~] Cruising"); break;
+        default: printf("[?] Unknown"); break;
+    }
+    printf("\n");
+}
+
+typedef struct {
+    int flightIndex;
+    int mask;
+} ActiveViolator;
+
+int compareActiveViolators(const void* a, const void* b) {
+    int x = ((const ActiveViolator*)a)->flightIndex, y = ((const ActiveViolator*)b)->flightIndex;
+    return (x > y) - (x < y);
+}
+
+// Copies the counters and the active set out of the index so the report can
+// be printed without holding it.
+ActiveViolator* copyViolationIndex(ViolationIndex* counts) {
+    pthread_mutex_lock(&violationIndexLock);
+    *counts = violationIndex;
+    ActiveViolator* active = malloc(sizeof(ActiveViolator) * (counts->activeCount > 0 ? counts->activeCount : 1));
+    for (int k = 0; active && k < counts->activeCount; k++) {
+        int i = violationIndex.activeViolators[k];
+        active[k] = (ActiveViolator){ i, violationIndex.entries[i].mask };
+    }
+    pthread_mutex_unlock(&violationIndexLock);
+    if (active) qsort(active, counts->activeCount, sizeof(ActiveViolator), compareActiveViolators);
+    return active;
+}
+
+void displayActiveViolations(Flight* flights, int flightCount) {
+    ViolationIndex counts;
+    ActiveViolator* active = copyViolationIndex(&counts);
+    printf("\033[92m");
+    printf("\n===== AirControlX Dashboard =====\n");
+    printf("Time: %d seconds\n", getCurrentSimulationTime());
+    printf("--------------------------------\n");
+    printf("Number of Active Violations: %d\n", counts.activeCount);
+    printf("Current Violations:");
+    for (int k = 0; k < VIOLATION_KINDS; k++) printf(" %s %d%s", violationKindNames[k], counts.kindCounts[k], k + 1 < VIOLATION_KINDS ? " |" : "\n");
+    for (int a = 0; a < airlineCount; a++) {
+        if (counts.airlineViolators[a] || counts.airlineAVNs[a]) {
+            printf("  %s: %d violating | %d AVNs\n", airlineName(a), counts.airlineViolators[a], counts.airlineAVNs[a]);
+        }
+    }
+    for (int p = 0; p < FLIGHT_PHASE_COUNT; p++) {
+        if (counts.phaseViolators[p]) printf("  %s: %d violating\n", getPhaseString((FlightPhase)p), counts.phaseViolators[p]);
+    }
+    printf("--------------------------------\n");
+    printf("Aircraft with Active Violations:\n");
+    for (int k = 0; active && k < counts.activeCount; k++) {
+        Flight* f = &flights[active[k].flightIndex];
+        int mask = active[k].mask;
+        printf("Flight %s | Airline: %s | Violations: %d | Status: %s\n",
+               f->id, airlineName(f->airlineId),
+               f->avnCount, f->avnStatus == ACTIVE ? "ACTIVE" : "INACTIVE");
+        if (mask & VIOLATION_SPEED) {
+            printf("  - Speed Violation: %d km/h (Safe: %d+)\n",
+                   f->speed, getMinAllowedSpeed(f->phase));
+        }
+        if (mask & VIOLATION_ALTITUDE) {
+            printf("  - Altitude Violation: %d ft (Safe: %d)\n",
+                   f->altitude, getSafeAltitudeForPhase(f->phase));
+        }
+        if (mask & VIOLATION_POSITION) {
+            PositionRange range = getSafePositionRangeForPhase(f->phase);
+            printf("  - Position Violation: %d (Safe: %d-%d)\n",
+                   f->position, range.min, range.max);
+        }
+        if (mask & VIOLATION_RUNWAY) {
+            printf("  - Runway Violation: %s (Direction: %s)\n",
+                   getRunwayString(f->assignedRunway), getDirectionString(f->direction));
+        }
+    }
+    free(active);
+    printf("--------------------------------\n");
     printf("Flight States Visualization:\n");
     for (int i = 0; i < flightCount; i++) {
-        displayFlightState(&flights[i]);
+        displayFlightState(&flights[i]);
+    }
+    printf("================================\n");
+    printf("\033[0m");
+}
+
+// Appends a line for every flight, then the running totals kept by the
+// violation index.
+void logS(Flight* flights, int flightCount) {
+    FILE* logFile = fopen("simulation_log.txt", "a");
+    if (!logFile) {
+        perror("Failed to open log file");
+        return;
+    }
+    fprintf(logFile, "\n--- Simulation Log ---\n");
+    fprintf(logFile, "Total Flights: %d\n", flightCount);
+    for (int i = 0; i < flightCount; i++) {
+        fprintf(logFile,
+                "Flight %s | Airline: %s | Type: %s | AVN: %d | Violations: %d | Fuel: %d%%\n",
+                flights[i].id, airlineName(flights[i].airlineId),
+                getFlightTypeString(flights[i].type), flights[i].avnCount,
+                isRunwayViolation(&flights[i]) ? 1 : 0, flights[i].fuelLevel);
+    }
+    pthread_mutex_lock(&violationIndexLock);
+    ViolationIndex* v = &violationIndex;
+    fprintf(logFile, "Total AVN Triggers: %d\n", v->avnTriggers);
+    fprintf(logFile, "Total Violations: %d\n", v->kindCounts[VIOLATION_KIND_RUNWAY]);
+    fprintf(logFile, "Emergency Landings: %d\n", v->emergencies);
+    pthread_mutex_unlock(&violationIndexLock);
+    fclose(logFile);
+}
+
+void FindWaitTime() {
+    for (int r = 0; r < runwayCount; r++) {
+        for (int i = 0; i < runways[r].queueCount; i++) runways[r].queue[i]->estimatedWait = i * 30;
+    }
+}
+
+// Scenario input. A movement is one scheduled arrival or departure; it comes
+// from a CSV or binary schedule file or from the parametric generator, and
+// is turned into a Flight exactly as the interactive menu would.
+#define SCENARIO_RANDOM -1
+#define SCENARIO_MAGIC "ATCSCN1"
+
+typedef struct {
+    uint8_t isDeparture;
+    uint8_t airlineId;
+    int8_t priority;
+    uint8_t isVIP;
+    int32_t scheduledTime;
+    int16_t fuelLevel;
+    int8_t direction;
+    uint8_t isEmergency;
+} ScenarioMovement;
+
+void enqueueFlight(Flight* f) {
+    RunwayConfig* r = &runways[isValidRunway(f->assignedRunway) ? f->assignedRunway : fallbackRunway()];
+    r->queue[r->queueCount++] = f;
+}
+
+// Rejects records no schedule can mean: flags other than 0 or 1, a fuel
+// level outside 0-100, or a direction the flight's kind never flies
+// (arrivals come in from the north or south, departures leave east or west).
+bool validScenarioMovement(const ScenarioMovement* m) {
+    if (m->isDeparture > 1 || m->isVIP > 1 || m->isEmergency > 1 || !isValidAirline(m->airlineId)) return false;
+    if (m->fuelLevel != SCENARIO_RANDOM && (m->fuelLevel < 0 || m->fuelLevel > 100)) return false;
+    if (m->direction == SCENARIO_RANDOM) return true;
+    if (m->isDeparture) return m->direction == EAST || m->direction == WEST;
+    return m->direction == NORTH || m->direction == SOUTH;
+}
+
+// Caller holds flightDataMutex. Queue order is settled by sortQueue and
+// QueuesReordering when the simulation starts, not per insertion.
+// A NULL id names the flight DEPnnn/ARRnnn after its slot.
+bool addScenarioFlight(Airline airlines[], Flight* flights, int* flightCount, const ScenarioMovement* m,
+                       const char* id) {
+    if (*flightCount >= MAX_FLIGHTS || !validScenarioMovement(m)) return false;
+    char generated[20];
+    if (!id) {
+        snprintf(generated, sizeof(generated), "%s%03d", m->isDeparture ? "DEP" : "ARR", *flightCount + 1);
+        id = generated;
+    }
+    Flight* f = &flights[*flightCount];
+    *f = generateFlight(airlines, m->airlineId, getCurrentSimulationTime(), id, m->isDeparture);
+    if (m->fuelLevel != SCENARIO_RANDOM) {
+        f->fuelLevel = m->fuelLevel;
+        if (f->fuelLevel < FUEL_THRESHOLD) f->isEmergency = true;
+    }
+    if (m->direction != SCENARIO_RANDOM) {
+        f->direction = (Direction)m->direction;
+        placeFlightForDirection(f);
+    }
+    if (m->isEmergency) f->isEmergency = true;
+    f->isVIP = m->isVIP;
+    f->assignedRunway = assignRunway(f);
+    initializeFlightPosition(f);
+    if (f->isEmergency || f->isVIP || f->type == EMERGENCY) f->priority = 3;
+    else f->priority = (m->priority < 0 || m->priority > 2) ? 0 : m->priority;
+    f->scheduledTime = m->scheduledTime < 0 ? 0 : m->scheduledTime;
+    enqueueFlight(f);
+    noteFlightChanged(f);
+    (*flightCount)++;
+    return true;
+}
+
+int findAirline(Airline airlines[], const char* text) {
+    char* end;
+    long index = strtol(text, &end, 10);
+    if (*text && *end == '\0') return (index >= 0 && index < airlineCount) ? (int)index : -1;
+    for (int i = 0; i < airlineCount; i++) {
+        if (strcasecmp(airlines[i].name, text) == 0) return i;
+    }
+    return -1;
+}
+
+int parseDirection(const char* text) {
+    if (strcasecmp(text, "NORTH") == 0 || strcasecmp(text, "N") == 0) return NORTH;
+    if (strcasecmp(text, "SOUTH") == 0 || strcasecmp(text, "S") == 0) return SOUTH;
+    if (strcasecmp(text, "EAST") == 0 || strcasecmp(text, "E") == 0) return EAST;
+    if (strcasecmp(text, "WEST") == 0 || strcasecmp(text, "W") == 0) return WEST;
+    return SCENARIO_RANDOM;
+}
+
+// Splits one CSV line in place; empty fields are kept as "".
+int splitCsv(char* line, char* fields[], int maxFields) {
+    int count = 0;
+    char* p = line;
+    while (count < maxFields) {
+        while (*p == ' ' || *p == '\t') p++;
+        fields[count++] = p;
+        char* comma = strchr(p, ',');
+        char* end = comma ? comma : p + strlen(p);
+        while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) end--;
+        if (!comma) {
+            *end = '\0';
+            break;
+        }
+        *end = '\0';
+        p = comma + 1;
+    }
+    return count;
+}
+
+// CSV columns: kind,airline,priority,scheduled_time[,fuel[,direction[,vip[,emergency]]]]
+// kind is arrival/departure (or A/D), airline is an index or a name, and
+// empty optional fields keep the random values generateFlight draws.
+bool parseScenarioLine(Airline airlines[], char* line, ScenarioMovement* m) {
+    char* fields[8];
+    int count = splitCsv(line, fields, 8);
+    if (count < 4 || fields[0][0] == '\0' || fields[0][0] == '#') return false;
+    memset(m, 0, sizeof(*m));
+    char kind = fields[0][0];
+    if (kind == 'a' || kind == 'A') m->isDeparture = 0;
+    else if (kind == 'd' || kind == 'D') m->isDeparture = 1;
+    else return false;
+    int airline = findAirline(airlines, fields[1]);
+    if (airline < 0) return false;
+    m->airlineId = airline;
+    m->priority = atoi(fields[2]);
+    m->scheduledTime = atoi(fields[3]);
+    m->fuelLevel = (count > 4 && fields[4][0]) ? atoi(fields[4]) : SCENARIO_RANDOM;
+    m->direction = (count > 5 && fields[5][0]) ? parseDirection(fields[5]) : SCENARIO_RANDOM;
+    if (m->direction == SCENARIO_RANDOM && count > 5 && fields[5][0]) return false;
+    m->isVIP = count > 6 && atoi(fields[6]) != 0;
+    m->isEmergency = count > 7 && atoi(fields[7]) != 0;
+    return true;
+}
+
+// Streams a schedule file into the flight store. Binary files start with
+// SCENARIO_MAGIC followed by packed ScenarioMovement records; anything else
+// is read as CSV. Returns the number of flights added, or -1 on error.
+int loadScenarioFile(const char* path, Airline airlines[], Flight* flights, int* flightCount) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror("Failed to open scenario file");
+        return -1;
+    }
+    int added = 0, rejected = 0;
+    char magic[sizeof(SCENARIO_MAGIC)];
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    lockFlightData();
+    if (got == sizeof(magic) && memcmp(magic, SCENARIO_MAGIC, sizeof(magic)) == 0) {
+        ScenarioMovement batch[1024];
+        size_t n;
+        while ((n = fread(batch, sizeof(ScenarioMovement), 1024, file)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                if (addScenarioFlight(airlines, flights, flightCount, &batch[i], NULL)) added++;
+                else rejected++;
+            }
+        }
+    } else {
+        rewind(file);
+        char line[256];
+        ScenarioMovement m;
+        while (fgets(line, sizeof(line), file)) {
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+            if (parseScenarioLine(airlines, line, &m) && addScenarioFlight(airlines, flights, flightCount, &m, NULL)) added++;
+            else rejected++;
+        }
+    }
+    unlockFlightData();
+    fclose(file);
+    if (rejected > 0) fprintf(stderr, "Scenario %s: %d movements rejected\n", path, rejected);
+    return added;
+}
+
+// Runway configuration, one runway per line:
+//   name, operations, directions, types, flags, x north[, x south, x east, x west]
+// operations is arrivals, departures or both; directions any of the letters
+// NSEW; types commercial, cargo, emergency, vip or all joined with '+'; flags
+// emergency and/or fallback joined with '+', or '-'. Missing lane positions
+// repeat the last one given.
+uint8_t parseFlightTypes(char* text) {
+    uint8_t types = 0;
+    char* save;
+    for (char* t = strtok_r(text, "+", &save); t; t = strtok_r(NULL, "+", &save)) {
+        if (strcasecmp(t, "all") == 0) types |= (1 << COMMERCIAL) | (1 << CARGO) | (1 << EMERGENCY) | (1 << VIP);
+        else if (strcasecmp(t, "commercial") == 0) types |= 1 << COMMERCIAL;
+        else if (strcasecmp(t, "cargo") == 0) types |= 1 << CARGO;
+        else if (strcasecmp(t, "emergency") == 0) types |= 1 << EMERGENCY;
+        else if (strcasecmp(t, "vip") == 0) types |= 1 << VIP;
+        else return 0;
+    }
+    return types;
+}
+
+bool loadRunwayConfig(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("Failed to open runway configuration");
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNo++;
+        char* fields[9];
+        int count = splitCsv(line, fields, 9);
+        if (fields[0][0] == '\0' || fields[0][0] == '#') continue;
+        ok = false;
+        if (count < 6) {
+            fprintf(stderr, "%s:%d: expected name, operations, directions, types, flags and lane x\n", path, lineNo);
+            break;
+        }
+        uint8_t operations = 0;
+        if (strcasecmp(fields[1], "arrivals") == 0) operations = RUNWAY_ARRIVALS;
+        else if (strcasecmp(fields[1], "departures") == 0) operations = RUNWAY_DEPARTURES;
+        else if (strcasecmp(fields[1], "both") == 0) operations = RUNWAY_ARRIVALS | RUNWAY_DEPARTURES;
+        uint8_t directions = 0;
+        for (const char* c = fields[2]; *c; c++) {
+            char letter[2] = {*c, '\0'};
+            int d = parseDirection(letter);
+            if (d == SCENARIO_RANDOM) {
+                directions = 0;
+                break;
+            }
+            directions |= 1 << d;
+        }
+        uint8_t types = parseFlightTypes(fields[3]);
+        uint8_t flags = 0;
+        if (strcmp(fields[4], "-") != 0 && fields[4][0] != '\0') {
+            char* save;
+            for (char* t = strtok_r(fields[4], "+", &save); t; t = strtok_r(NULL, "+", &save)) {
+                if (strcasecmp(t, "emergency") == 0) flags |= RUNWAY_EMERGENCY;
+                else if (strcasecmp(t, "fallback") == 0) flags |= RUNWAY_FALLBACK;
+                else operations = 0;
+            }
+        }
+        if (!operations || !directions || !types) {
+            fprintf(stderr, "%s:%d: invalid runway definition\n", path, lineNo);
+            break;
+        }
+        float laneX[4];
+        for (int d = 0; d < 4; d++) laneX[d] = (float)atof(fields[5 + (d < count - 5 ? d : count - 6)]);
+        if (!addRunway(fields[0], operations, directions, types, flags, laneX)) {
+            fprintf(stderr, "%s:%d: too many runways (at most %d)\n", path, lineNo, MAX_RUNWAYS);
+            break;
+        }
+        ok = true;
+    }
+    fclose(file);
+    if (ok && runwayCount == 0) {
+        fprintf(stderr, "%s defines no runways\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Airline registry file, one airline per line in id order:
+//   name, type (commercial|cargo|emergency), fleet size, available[, icon]
+// where icon is commercial, cargo, emergency or military and defaults to
+// the one matching the type.
+bool loadAirlineRegistry(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("Failed to open airline registry");
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNo++;
+        char* fields[5];
+        int count = splitCsv(line, fields, 5);
+        if (fields[0][0] == '\0' || fields[0][0] == '#') continue;
+        ok = false;
+        if (count < 4) {
+            fprintf(stderr, "%s:%d: expected name, type, fleet size and available aircraft\n", path, lineNo);
+            break;
+        }
+        uint8_t types = parseFlightTypes(fields[1]);
+        FlightType type = types == 1 << COMMERCIAL ? COMMERCIAL : types == 1 << CARGO ? CARGO : EMERGENCY;
+        AirlineIcon icon = type == CARGO ? ICON_CARGO : type == EMERGENCY ? ICON_EMERGENCY : ICON_COMMERCIAL;
+        if (count > 4) {
+            if (strcasecmp(fields[4], "commercial") == 0) icon = ICON_COMMERCIAL;
+            else if (strcasecmp(fields[4], "cargo") == 0) icon = ICON_CARGO;
+            else if (strcasecmp(fields[4], "emergency") == 0) icon = ICON_EMERGENCY;
+            else if (strcasecmp(fields[4], "military") == 0) icon = ICON_MILITARY;
+            else types = 0;
+        }
+        int fleet = atoi(fields[2]);
+        int available = atoi(fields[3]);
+        if ((types != 1 << COMMERCIAL && types != 1 << CARGO && types != 1 << EMERGENCY) ||
+            fleet < 0 || available < 0 || available > fleet) {
+            fprintf(stderr, "%s:%d: invalid airline definition\n", path, lineNo);
+            break;
+        }
+        if (!addAirline(fields[0], type, fleet, available, icon)) {
+            fprintf(stderr, "%s:%d: too many airlines (at most %d)\n", path, lineNo, MAX_AIRLINES);
+            break;
+        }
+        ok = true;
+    }
+    fclose(file);
+    if (ok && airlineCount == 0) {
+        fprintf(stderr, "%s defines no airlines\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+typedef struct {
+    int arrivalsPerHour;
+    int departuresPerHour;
+    int durationSeconds;
+    int emergencyPercent;
+    int vipPercent;
+    int fuelMean;
+    int fuelSpread;
+    int airlineWeights[MAX_AIRLINES];
+} TrafficProfile;
+
+// Parses "arrivals=60,departures=40,duration=3600,emergency=2,vip=10,
+// fuel_mean=60,fuel_sd=20,mix=4:4:2:1:2:1". Unspecified keys keep defaults;
+// the default airline mix follows each airline's fleet size.
+bool parseTrafficProfile(const char* spec, Airline airlines[], TrafficProfile* p) {
+    memset(p, 0, sizeof(*p));
+    p->arrivalsPerHour = 60;
+    p->departuresPerHour = 60;
+    p->durationSeconds = 3600;
+    p->emergencyPercent = 2;
+    p->vipPercent = 10;
+    p->fuelMean = 60;
+    p->fuelSpread = 20;
+    for (int i = 0; i < airlineCount; i++) p->airlineWeights[i] = airlines[i].totalAircrafts;
+    char buffer[256];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        if (!eq) return false;
+        *eq = '\0';
+        const char* value = eq + 1;
+        if (strcmp(item, "arrivals") == 0) p->arrivalsPerHour = atoi(value);
+        else if (strcmp(item, "departures") == 0) p->departuresPerHour = atoi(value);
+        else if (strcmp(item, "duration") == 0) p->durationSeconds = atoi(value);
+        else if (strcmp(item, "emergency") == 0) p->emergencyPercent = atoi(value);
+        else if (strcmp(item, "vip") == 0) p->vipPercent = atoi(value);
+        else if (strcmp(item, "fuel_mean") == 0) p->fuelMean = atoi(value);
+        else if (strcmp(item, "fuel_sd") == 0) p->fuelSpread = atoi(value);
+        else if (strcmp(item, "mix") == 0) {
+            const char* w = value;
+            for (int i = 0; i < airlineCount && *w; i++) {
+                p->airlineWeights[i] = atoi(w);
+                while (*w && *w != ':') w++;
+                if (*w == ':') w++;
+            }
+        } else return false;
+    }
+    return p->durationSeconds > 0;
+}
+
+int pickAirline(const TrafficProfile* p, RngStream* rng) {
+    int total = 0;
+    for (int i = 0; i < airlineCount; i++) total += p->airlineWeights[i];
+    if (total <= 0) return rngBelow(rng, airlineCount);
+    int pick = rngBelow(rng, total);
+    for (int i = 0; i < airlineCount; i++) {
+        if (pick < p->airlineWeights[i]) return i;
+        pick -= p->airlineWeights[i];
+    }
+    return airlineCount - 1;
+}
+
+// Approximately normal fuel level (Irwin-Hall sum of twelve uniforms).
+int drawFuelLevel(const TrafficProfile* p, RngStream* rng) {
+    int sum = 0;
+    for (int i = 0; i < 12; i++) sum += rngBelow(rng, 1000);
+    int fuel = p->fuelMean + (sum - 6000) * p->fuelSpread / 1000;
+    return fuel < 0 ? 0 : (fuel > 100 ? 100 : fuel);
+}
+
+int compareMovements(const void* a, const void* b) {
+    const ScenarioMovement* m1 = (const ScenarioMovement*)a;
+    const ScenarioMovement* m2 = (const ScenarioMovement*)b;
+    return m1->scheduledTime - m2->scheduledTime;
+}
+
+// Fills `out` with a schedule drawn from the profile. Movement counts follow
+// the hourly rates and start times are uniform over the duration, i.e. a
+// Poisson process conditioned on its count. Returns the number generated.
+int generateTraffic(const TrafficProfile* p, ScenarioMovement* out, int capacity) {
+    RngStream rng;
+    rngSeed(&rng, scenarioSeed, streamIdFor("traffic-generator"));
+    int arrivals = (int)((long long)p->arrivalsPerHour * p->durationSeconds / 3600);
+    int departures = (int)((long long)p->departuresPerHour * p->durationSeconds / 3600);
+    int count = 0;
+    for (int i = 0; i < arrivals + departures && count < capacity; i++) {
+        ScenarioMovement* m = &out[count++];
+        memset(m, 0, sizeof(*m));
+        m->isDeparture = i >= arrivals;
+        m->airlineId = pickAirline(p, &rng);
+        m->priority = rngBelow(&rng, 3);
+        m->scheduledTime = rngBelow(&rng, p->durationSeconds);
+        m->fuelLevel = m->isDeparture ? 100 : drawFuelLevel(p, &rng);
+        m->direction = SCENARIO_RANDOM;
+        m->isVIP = rngBelow(&rng, 100) < p->vipPercent;
+        m->isEmergency = rngBelow(&rng, 100) < p->emergencyPercent;
+    }
+    qsort(out, count, sizeof(ScenarioMovement), compareMovements);
+    return count;
+}
+
+bool writeScenarioFile(const char* path, const ScenarioMovement* movements, int count, Airline airlines[]) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror("Failed to write scenario file");
+        return false;
+    }
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".bin") == 0) {
+        fwrite(SCENARIO_MAGIC, 1, sizeof(SCENARIO_MAGIC), file);
+        fwrite(movements, sizeof(ScenarioMovement), count, file);
+    } else {
+        fprintf(file, "# kind,airline,priority,scheduled_time,fuel,direction,vip,emergency\n");
+        for (int i = 0; i < count; i++) {
+            const ScenarioMovement* m = &movements[i];
+            fprintf(file, "%s,%s,%d,%d,", m->isDeparture ? "departure" : "arrival",
+                    airlines[m->airlineId].name, m->priority, m->scheduledTime);
+            if (m->fuelLevel != SCENARIO_RANDOM) fprintf(file, "%d", m->fuelLevel);
+            fprintf(file, ",%s,%d,%d\n", m->direction == SCENARIO_RANDOM ? "" : getDirectionString(m->direction),
+                    m->isVIP, m->isEmergency);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Generates traffic from `spec`, optionally saves it, and loads it into the
+// flight store. Returns the number of flights added, or -1 on error.
+int loadGeneratedTraffic(const char* spec, const char* savePath, Airline airlines[], Flight* flights, int* flightCount) {
+    TrafficProfile profile;
+    if (!parseTrafficProfile(spec, airlines, &profile)) {
+        fprintf(stderr, "Invalid traffic profile: %s\n", spec);
+        return -1;
+    }
+    ScenarioMovement* movements = malloc(sizeof(ScenarioMovement) * MAX_FLIGHTS);
+    if (!movements) {
+        perror("Failed to allocate traffic");
+        return -1;
+    }
+    int count = generateTraffic(&profile, movements, MAX_FLIGHTS - *flightCount);
+    if (savePath) writeScenarioFile(savePath, movements, count, airlines);
+    int added = 0;
+    lockFlightData();
+    for (int i = 0; i < count; i++) {
+        if (addScenarioFlight(airlines, flights, flightCount, &movements[i], NULL)) added++;
+    }
+    unlockFlightData();
+    free(movements);
+    return added;
+}
+
+// Payments go to stipepay over one SOCK_SEQPACKET connection (--sp-socket),
+// opened on the first payment. Every request carries an id and any number
+// may be outstanding; stipepay answers each with the ids of the tickets it
+// settled and then a total, echoing the id, so a batch of airlines is paid
+// in one pipelined round trip. A settlement takes effect only once its total
+// has been sent; stipepay pays nothing for an answer it could not deliver.
+// The records mirror stipepay.c.
+#define SP_SOCKET_PATH "ATCtoSP.sock"
+#define PAYMENT_IDS_PER_MESSAGE 64
+#define PAYMENT_TIMEOUT_MS 5000
+
+typedef enum { PAYMENT_SETTLE = 1 } PaymentRequestType;
+typedef enum { PAYMENT_SETTLED = 1, PAYMENT_TOTAL, PAYMENT_REJECTED } PaymentResponseType;
+
+typedef struct {
+    uint32_t requestId;
+    uint32_t type;
+    int32_t airlineId;
+} PaymentRequest;
+
+typedef struct {
+    uint32_t requestId;
+    uint32_t type;
+    int32_t airlineId;
+    int32_t count;       // ids below (SETTLED) or tickets settled (TOTAL)
+    int64_t amount;      // sum over the ids below, or the request's total
+    int32_t ticketIds[PAYMENT_IDS_PER_MESSAGE];
+} PaymentResponse;
+
+typedef struct {
+    int airlineId;
+    int tickets;
+    int64_t amount;
+    bool done;
+    bool rejected;
+} PaymentSettlement;
+
+const char* spSocketPath = SP_SOCKET_PATH;
+int paymentFd = -1;
+uint32_t nextPaymentRequest = 1;
+
+bool connectPaymentSocket() {
+    if (paymentFd >= 0) return true;
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("socket failed");
+        return false;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", spSocketPath);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("Failed to connect to payment socket");
+        close(fd);
+        return false;
+    }
+    paymentFd = fd;
+    return true;
+}
+
+void closePaymentSocket() {
+    if (paymentFd < 0) return;
+    close(paymentFd);
+    paymentFd = -1;
+}
+
+// Settles every airline in airlineIds, writing requests while answers are
+// read so neither side waits on the other. Answers to requests from an
+// earlier, abandoned batch carry older ids and are skipped.
+bool settleAirlines(const int* airlineIds, int count, PaymentSettlement* results) {
+    if (!connectPaymentSocket()) return false;
+    uint32_t base = nextPaymentRequest;
+    nextPaymentRequest += (uint32_t)count;
+    for (int i = 0; i < count; i++) results[i] = (PaymentSettlement){ airlineIds[i], 0, 0, false, false };
+    int sent = 0;
+    int done = 0;
+    while (done < count) {
+        struct pollfd pfd = { .fd = paymentFd, .events = POLLIN | (sent < count ? POLLOUT : 0) };
+        int ready = poll(&pfd, 1, PAYMENT_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            fprintf(stderr, "Payment service did not answer (%d of %d settled; the rest stay unpaid)\n", done, count);
+            closePaymentSocket();
+            return false;
+        }
+        if (pfd.revents & POLLOUT) {
+            PaymentRequest request = { base + (uint32_t)sent, PAYMENT_SETTLE, airlineIds[sent] };
+            if (send(paymentFd, &request, sizeof(request), MSG_NOSIGNAL | MSG_DONTWAIT) == sizeof(request)) sent++;
+        }
+        if (!(pfd.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        PaymentResponse response;
+        ssize_t n = recv(paymentFd, &response, sizeof(response), MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n < (ssize_t)offsetof(PaymentResponse, ticketIds)) {
+            fprintf(stderr, "Payment service closed the connection (%d of %d settled; the rest stay unpaid)\n", done, count);
+            closePaymentSocket();
+            return false;
+        }
+        uint32_t slot = response.requestId - base;
+        if (slot >= (uint32_t)count || results[slot].done) continue;
+        PaymentSettlement* r = &results[slot];
+        switch (response.type) {
+            case PAYMENT_SETTLED: {
+                int ids = response.count;
+                int carried = (int)((n - offsetof(PaymentResponse, ticketIds)) / sizeof(int32_t));
+                if (ids > carried) ids = carried;
+                for (int i = 0; i < ids; i++) {
+                    printf("\033[34mSettling ticket %d for %s\033[0m\n", response.ticketIds[i],
+                           airlineName(r->airlineId));
+                }
+                break;
+            }
+            case PAYMENT_TOTAL:
+                r->tickets = response.count;
+                r->amount = response.amount;
+                r->done = true;
+                done++;
+                break;
+            default:
+                r->rejected = r->done = true;
+                done++;
+                break;
+        }
+    }
+    return true;
+}
+
+// Mirrors the ticket record avn.c forwards to stipepay.c over AVNtoSP.
+typedef struct {
+    int id;
+    int status;
+    int amount;
+    FlightType airlinetype;
+    int airlineId;
+    uint64_t traceId;
+    uint64_t detectedNs;
+    uint64_t issuedNs;
+    uint64_t ledgerNs;
+} TicketData;
+
+#define BENCH_MIN_NS 200000000ULL
+
+typedef struct {
+    FILE* out;
+    int results;
+} BenchReport;
+
+void benchResult(BenchReport* report, const char* name, int size, long iterations, uint64_t elapsedNs) {
+    double nsPerOp = iterations ? (double)elapsedNs / iterations : 0;
+    fprintf(report->out, "%s\n    {\"name\": \"%s\", \"size\": %d, \"iterations\": %ld, "
+            "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f}",
+            report->results ? "," : "", name, size, iterations, nsPerOp,
+            nsPerOp > 0 ? 1e9 / nsPerOp : 0);
+    report->results++;
+    fprintf(stderr, "%-28s size=%-6d %12.1f ns/op\n", name, size, nsPerOp);
+}
+
+Flight* makeBenchFlights(Airline airlines[], int count) {
+    Flight* flights = calloc(count, sizeof(Flight));
+    if (!flights) return NULL;
+    char id[20];
+    for (int i = 0; i < count; i++) {
+        snprintf(id, sizeof(id), "BEN%05d", i);
+        flights[i] = generateFlight(airlines, rngBelow(&controlRng, airlineCount), 0, id, rngBelow(&controlRng, 2));
+        if (flights[i].priority == 0) flights[i].priority = rngBelow(&controlRng, 3);
+        flights[i].scheduledTime = rngBelow(&controlRng, 3600);
+        flights[i].assignedRunway = assignRunway(&flights[i]);
+    }
+    return flights;
+}
+
+void benchSortQueue(BenchReport* report, Flight* flights, int size) {
+    Flight** original = malloc(sizeof(Flight*) * size);
+    Flight** queue = malloc(sizeof(Flight*) * size);
+    if (!original || !queue) {
+        free(original);
+        free(queue);
+        return;
+    }
+    for (int i = 0; i < size; i++) original[i] = &flights[i];
+    uint64_t elapsed = 0;
+    long iterations = 0;
+    while (elapsed < BENCH_MIN_NS) {
+        memcpy(queue, original, sizeof(Flight*) * size);
+        uint64_t start = monotonicNs();
+        sortQueue(queue, size);
+        elapsed += monotonicNs() - start;
+        iterations++;
+    }
+    benchResult(report, "sortQueue", size, iterations, elapsed);
+    free(original);
+    free(queue);
+}
+
+void benchQueuesReordering(BenchReport* report, Flight* flights, int size) {
+    int perQueue = size / runwayCount;
+    if (perQueue > MAX_FLIGHTS) perQueue = MAX_FLIGHTS;
+    uint64_t elapsed = 0;
+    long iterations = 0;
+    while (elapsed < BENCH_MIN_NS) {
+        for (int r = 0; r < runwayCount; r++) {
+            for (int i = 0; i < perQueue; i++) runways[r].queue[i] = &flights[r * perQueue + i];
+            runways[r].queueCount = perQueue;
+        }
+        uint64_t start = monotonicNs();
+        QueuesReordering();
+        elapsed += monotonicNs() - start;
+        iterations++;
+    }
+    for (int r = 0; r < runwayCount; r++) runways[r].queueCount = 0;
+    benchResult(report, "QueuesReordering", perQueue * runwayCount, iterations, elapsed);
+}
+
+void benchEnvelopeChecks(BenchReport* report, Flight* flights, int size) {
+    volatile int violations = 0;
+    uint64_t elapsed = 0;
+    long iterations = 0;
+    while (elapsed < BENCH_MIN_NS) {
+        uint64_t start = monotonicNs();
+        for (int i = 0; i < size; i++) {
+            Flight* f = &flights[i];
+            violations += check_speedViolation(f) + check_altitudeViolation(f) +
+                          check_positionViolation(f) + isRunwayViolation(f);
+        }
+        elapsed += monotonicNs() - start;
+        iterations += size;
+    }
+    benchResult(report, "envelope_checks_per_flight", size, iterations, elapsed);
+}
+
+void benchAssignRunway(BenchReport* report, Flight* flights, int size) {
+    volatile int runways = 0;
+    uint64_t elapsed = 0;
+    long iterations = 0;
+    while (elapsed < BENCH_MIN_NS) {
+        uint64_t start = monotonicNs();
+        for (int i = 0; i < size; i++) runways += assignRunway(&flights[i]);
+        elapsed += monotonicNs() - start;
+        iterations += size;
+    }
+    benchResult(report, "assignRunway", size, iterations, elapsed);
+}
+
+// Pushes `count` records through a FIFO to a forked stand-in reader. With
+// reopenPerRecord the writer opens and closes the FIFO around every record,
+// exactly as handleAVN* does today.
+uint64_t benchFifo(const char* path, size_t recordSize, int count, bool reopenPerRecord) {
+    unlink(path);
+    if (mkfifo(path, 0666) < 0) {
+        perror("mkfifo failed");
+        return 0;
+    }
+    pid_t reader = fork();
+    if (reader < 0) {
+        perror("fork failed");
+        return 0;
+    }
+    if (reader == 0) {
+        char buffer[4096];
+        int fd = open(path, O_RDONLY);
+        int received = 0;
+        while (received < count && fd >= 0) {
+            ssize_t r = read(fd, buffer, recordSize);
+            if (r == (ssize_t)recordSize) received++;
+            else if (r == 0) {
+                close(fd);
+                fd = open(path, O_RDONLY);
+            } else if (r < 0 && errno != EINTR) break;
+        }
+        _exit(received == count ? 0 : 1);
+    }
+    char* record = calloc(1, recordSize);
+    uint64_t start = monotonicNs();
+    int fd = -1;
+    for (int i = 0; i < count; i++) {
+        if (fd < 0) fd = open(path, O_WRONLY);
+        if (fd < 0) break;
+        write(fd, record, recordSize);
+        if (reopenPerRecord) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0) close(fd);
+    int status = 0;
+    waitpid(reader, &status, 0);
+    uint64_t elapsed = monotonicNs() - start;
+    free(record);
+    unlink(path);
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? elapsed : 0;
+}
+
+void benchIpc(BenchReport* report) {
+    char dir[] = "/tmp/atcbenchXXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp failed");
+        return;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "%s/ATCtoAVN", dir);
+    const int streamed = 100000, reopened = 5000;
+    uint64_t elapsed = benchFifo(path, sizeof(AVNData), reopened, true);
+    if (elapsed) benchResult(report, "ATCtoAVN_open_per_notice", reopened, reopened, elapsed);
+    elapsed = benchFifo(path, sizeof(AVNData), streamed, false);
+    if (elapsed) benchResult(report, "ATCtoAVN_streamed", streamed, streamed, elapsed);
+    snprintf(path, sizeof(path), "%s/AVNtoSP", dir);
+    elapsed = benchFifo(path, sizeof(TicketData), reopened, true);
+    if (elapsed) benchResult(report, "AVNtoSP_open_per_ticket", reopened, reopened, elapsed);
+    elapsed = benchFifo(path, sizeof(TicketData), streamed, false);
+    if (elapsed) benchResult(report, "AVNtoSP_streamed", streamed, streamed, elapsed);
+    rmdir(dir);
+}
+
+// Runs the benchmark suite headless and writes JSON results to outPath
+// (stdout when NULL); a human-readable summary goes to stderr.
+int runBenchmarks(Airline airlines[], const char* outPath) {
+    const int sizes[] = {20, 1000, 10000};
+    const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+    BenchReport report = {stdout, 0};
+    if (outPath) {
+        report.out = fopen(outPath, "w");
+        if (!report.out) {
+            perror("Failed to open benchmark output");
+            return 1;
+        }
+    }
+    fprintf(report.out, "{\n  \"seed\": %llu,\n  \"max_flights\": %d,\n  \"results\": [",
+            (unsigned long long)scenarioSeed, MAX_FLIGHTS);
+    Flight* flights = makeBenchFlights(airlines, sizes[sizeCount - 1]);
+    if (!flights) {
+        perror("Failed to allocate benchmark flights");
+        return 1;
+    }
+    for (int i = 0; i < sizeCount; i++) {
+        benchSortQueue(&report, flights, sizes[i]);
+        benchQueuesReordering(&report, flights, sizes[i]);
+        benchEnvelopeChecks(&report, flights, sizes[i]);
+        benchAssignRunway(&report, flights, sizes[i]);
+    }
+    benchIpc(&report);
+    fprintf(report.out, "\n  ]\n}\n");
+    if (report.out != stdout) fclose(report.out);
+    free(flights);
+    return 0;
+}
+
+typedef struct {
+    long events;
+    long violations;
+    long mismatches;
+    long lockConflicts;
+} ReplayStats;
+
+// Every field that picks a table entry or an enum value is checked before it
+// is used; a record failing that is corrupt and is not replayed.
+bool validTraceFlight(const TraceEvent* e) {
+    return isValidAirline(e->values[0]) && (e->values[1] == 0 || e->values[1] == 1) && e->values[2] >= NORTH &&
+           e->values[2] <= WEST && e->values[7] >= COMMERCIAL && e->values[7] <= VIP &&
+           e->phase < FLIGHT_PHASE_COUNT;
+}
+
+// The id is a placeholder until the TRACE_FLIGHT_ID record that follows.
+void replayCreateFlight(Airline airlines[], Flight* flights, int* flightCount, const TraceEvent* e) {
+    char id[20];
+    snprintf(id, sizeof(id), "%s%03d", e->values[1] ? "DEP" : "ARR", e->flightIndex + 1);
+    Flight* f = &flights[*flightCount];
+    *f = generateFlight(airlines, e->values[0], 0, id, e->values[1]);
+    f->direction = (Direction)e->values[2];
+    f->fuelLevel = e->values[3];
+    f->priority = e->values[4];
+    f->scheduledTime = e->values[5];
+    f->isEmergency = (e->values[6] & 1) != 0;
+    f->isVIP = (e->values[6] & 2) != 0;
+    f->type = (FlightType)e->values[7];
+    f->phase = (FlightPhase)e->phase;
+    f->assignedRunway = assignRunway(f);
+    initializeFlightPosition(f);
+    noteFlightChanged(f);
+    (*flightCount)++;
+}
+
+// Applies one recorded event to the flight store. Violation events are
+// checked against the envelope checks run on the replayed state, and lock
+// events against the replayed runway owners, so any divergence is counted.
+void replayApply(const TraceEvent* e, Flight* flights, int flightCount, int runwayOwner[], ReplayStats* stats) {
+    if ((int)e->flightIndex >= flightCount) {
+        stats->mismatches++;
+        return;
+    }
+    Flight* f = &flights[e->flightIndex];
+    bool runwayEvent = e->type == TRACE_RUNWAY_ASSIGNED || e->type == TRACE_LOCK_GRANT || e->type == TRACE_LOCK_RELEASE;
+    if ((runwayEvent && !isValidRunway((Runway)e->values[0])) ||
+        (e->type == TRACE_PHASE_ENTERED && e->phase >= FLIGHT_PHASE_COUNT)) {
+        stats->mismatches++;
+        return;
+    }
+    switch (e->type) {
+        case TRACE_RUNWAY_ASSIGNED:
+            f->isEmergency = e->values[1];
+            if (assignRunway(f) != (Runway)e->values[0]) stats->mismatches++;
+            f->assignedRunway = (Runway)e->values[0];
+            noteFlightChanged(f);
+            break;
+        case TRACE_LOCK_GRANT:
+            if (runwayOwner[e->values[0]] != -1) stats->lockConflicts++;
+            runwayOwner[e->values[0]] = e->flightIndex;
+            break;
+        case TRACE_LOCK_RELEASE:
+            if (runwayOwner[e->values[0]] != (int)e->flightIndex) stats->lockConflicts++;
+            runwayOwner[e->values[0]] = -1;
+            break;
+        case TRACE_PHASE_ENTERED:
+            f->phase = (FlightPhase)e->phase;
+            f->speed = e->values[0];
+            f->altitude = e->values[1];
+            f->position = e->values[2];
+            f->x = e->x;
+            f->y = e->y;
+            f->targetY = e->targetY;
+            if (f->sprite) sfSprite_setPosition(f->sprite, (sfVector2f){f->x, f->y});
+            noteFlightChanged(f);
+            break;
+        case TRACE_FAULT:
+            f->hasFault = true;
+            break;
+        case TRACE_VIOLATION:
+            stats->violations++;
+            if (violationMask(f) != e->values[0]) stats->mismatches++;
+            f->speed = e->values[1];
+            f->altitude = e->values[2];
+            f->position = e->values[3];
+            f->avnCount = e->values[4];
+            if (f->avnCount > 0) f->avnStatus = ACTIVE;
+            noteFlightChanged(f);
+            break;
+        case TRACE_FLIGHT_DONE:
+            if (f->sprite) {
+                sfSprite_destroy(f->sprite);
+                f->sprite = NULL;
+            }
+            break;
+        case TRACE_FLIGHT_ID:
+            memcpy(f->id, e->values, sizeof(f->id) - 1);
+            f->id[sizeof(f->id) - 1] = '\0';
+            noteFlightChanged(f);
+            break;
+        default:
+            break;
+    }
+}
+
+// Replays a recorded trace as fast as the events can be applied. No AVNs
+// are sent; the run ends with the usual dashboard and a divergence report.
+int replayTrace(const char* path, Airline airlines[], Flight* flights, int* flightCount, ThreadData* threadData) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror("Failed to open trace");
+        return 1;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.recordSize != sizeof(TraceEvent)) {
+        fprintf(stderr, "%s is not a flight trace\n", path);
+        fclose(file);
+        return 1;
+    }
+    if (header.runwayCount != (uint32_t)runwayCount) {
+        fprintf(stderr, "%s was recorded with %u runways, this configuration has %d\n", path, header.runwayCount,
+                runwayCount);
+        fclose(file);
+        return 1;
+    }
+    if (header.airlineCount != (uint32_t)airlineCount) {
+        fprintf(stderr, "%s was recorded with %u airlines, this registry has %d\n", path, header.airlineCount,
+                airlineCount);
+        fclose(file);
+        return 1;
+    }
+    scenarioSeed = header.seed;
+    int runwayOwner[MAX_RUNWAYS];
+    for (int i = 0; i < MAX_RUNWAYS; i++) runwayOwner[i] = -1;
+    ReplayStats stats = {0};
+    TraceEvent batch[4096];
+    size_t n;
+    uint64_t start = monotonicNs();
+    while ((n = fread(batch, sizeof(TraceEvent), 4096, file)) > 0) {
+        lockFlightData();
+        for (size_t i = 0; i < n; i++) {
+            stats.events++;
+            if (batch[i].type == TRACE_FLIGHT_CREATED) {
+                if ((int)batch[i].flightIndex != *flightCount || *flightCount >= MAX_FLIGHTS ||
+                    !validTraceFlight(&batch[i])) {
+                    stats.mismatches++;
+                    continue;
+                }
+                replayCreateFlight(airlines, flights, flightCount, &batch[i]);
+                if (threadData) threadData->flightCount = *flightCount;
+            } else {
+                replayApply(&batch[i], flights, *flightCount, runwayOwner, &stats);
+            }
+        }
+        unlockFlightData();
+    }
+    uint64_t elapsed = monotonicNs() - start;
+    fclose(file);
+    printf("Replayed %ld events for %d flights in %.3f ms (%.0f events/s)\n", stats.events, *flightCount,
+           elapsed / 1e6, elapsed ? stats.events * 1e9 / elapsed : 0.0);
+    printf("Recorded seed: %llu | Violations: %ld | Mismatches: %ld | Lock conflicts: %ld\n",
+           (unsigned long long)header.seed, stats.violations, stats.mismatches, stats.lockConflicts);
+    displayActiveViolations(flights, *flightCount);
+    return stats.mismatches || stats.lockConflicts ? 2 : 0;
+}
+
+// Surveillance feed (--radar SOURCE). Each position report is a text line
+// "id,x,y,altitude,speed,timestamp". SOURCE is either a recorded file, which
+// is mapped and parsed where it lies, or unix:PATH, a stream socket q1 listens
+// on for one feeder, parsed in place from the receive buffer. Reports are
+// matched to flights through a hash index on the flight id and then run
+// through the same envelope checks the simulation ticks use.
+//
+// A report with an empty id is a plot from a sensor that does not identify
+// the aircraft. It is associated with the nearest predicted track within the
+// gate (--radar-gate) through a k-d tree rebuilt once per batch. Reports that
+// land on the same track within RADAR_FUSE_WINDOW seconds are duplicates from
+// overlapping sensors and are averaged into one fix before the flight moves.
+#define RADAR_BATCH 4096
+#define RADAR_BUFFER_SIZE (1 << 20)
+#define DEFAULT_RADAR_GATE 30.0f
+#define RADAR_FUSE_WINDOW 0.5
+
+float radarGate = DEFAULT_RADAR_GATE;
+
+typedef struct {
+    int32_t* slots;       // flight index + 1, 0 when empty
+    uint32_t mask;
+} FlightIndex;
+
+// Implicit k-d tree: order[] is arranged so the median of every range splits
+// it, on x at even depths and y at odd ones.
+typedef struct {
+    int32_t* order;
+    float* predictedX;
+    float* predictedY;
+    int count;
+    double predictedAt;   // feed time the predictions are for, NAN when stale
+} TrackTree;
+
+// Reports fused into the next fix of one track.
+typedef struct {
+    double x;
+    double y;
+    double altitude;
+    double speed;
+    double newest;
+    int reports;
+    bool queued;          // listed in RadarFeed.pending
+} RadarFix;
+
+typedef struct {
+    Flight* flights;
+    FlightIndex index;
+    TrackTree tree;
+    RadarFix* fixes;
+    int32_t* pending;     // flights with a fix waiting for the end of the batch
+    int pendingCount;
+    double* lastSeen;     // newest report time per flight, to drop stale ones
+    double clock;         // newest report time so far, for track prediction
+    uint64_t started;     // when the first byte became available
+    long reports;
+    long matched;
+    long associated;
+    long unassociated;
+    long fused;
+    long unknown;
+    long malformed;
+    long stale;
+    long violations;
+} RadarFeed;
+
+bool buildFlightIndex(FlightIndex* index, Flight* flights, int flightCount) {
+    uint32_t capacity = 16;
+    while (capacity < (uint32_t)flightCount * 2) capacity <<= 1;
+    index->slots = calloc(capacity, sizeof(int32_t));
+    if (!index->slots) return false;
+    index->mask = capacity - 1;
+    for (int i = 0; i < flightCount; i++) {
+        uint32_t slot = (uint32_t)streamIdFor(flights[i].id) & index->mask;
+        while (index->slots[slot]) slot = (slot + 1) & index->mask;
+        index->slots[slot] = i + 1;
+    }
+    return true;
+}
+
+Flight* findIndexedFlight(const FlightIndex* index, Flight* flights, const char* id, size_t length) {
+    if (length == 0 || length >= sizeof(flights[0].id)) return NULL;
+    uint32_t slot = (uint32_t)fnvHash(FNV_OFFSET_BASIS, id, length) & index->mask;
+    for (int32_t entry; (entry = index->slots[slot]) != 0; slot = (slot + 1) & index->mask) {
+        Flight* f = &flights[entry - 1];
+        if (f->id[length] == '\0' && memcmp(f->id, id, length) == 0) return f;
+    }
+    return NULL;
+}
+
+// Partially sorts order[lo, hi) so order[k] holds the k-th smallest key.
+void selectTrackMedian(int32_t* order, int lo, int hi, int k, const float* key) {
+    while (hi - lo > 1) {
+        float pivot = key[order[(lo + hi) / 2]];
+        int i = lo, j = hi - 1;
+        while (i <= j) {
+            while (key[order[i]] < pivot) i++;
+            while (key[order[j]] > pivot) j--;
+            if (i <= j) {
+                int32_t t = order[i];
+                order[i++] = order[j];
+                order[j--] = t;
+            }
+        }
+        if (k <= j) hi = j + 1;
+        else if (k >= i) lo = i;
+        else return;
+    }
+}
+
+void buildTrackTree(TrackTree* tree, int lo, int hi, int axis) {
+    if (hi - lo <= 1) return;
+    int mid = (lo + hi) / 2;
+    selectTrackMedian(tree->order, lo, hi, mid, axis ? tree->predictedY : tree->predictedX);
+    buildTrackTree(tree, lo, mid, !axis);
+    buildTrackTree(tree, mid + 1, hi, !axis);
+}
+
+// Dead-reckons every track to the feed clock, from its pending fix when it
+// has one, and rebuilds the tree over the predicted positions.
+void predictTracks(RadarFeed* feed) {
+    TrackTree* tree = &feed->tree;
+    for (int i = 0; i < tree->count; i++) {
+        Flight* f = &feed->flights[i];
+        RadarFix* fix = &feed->fixes[i];
+        float x = fix->reports > 0 ? (float)(fix->x / fix->reports) : f->x;
+        float y = fix->reports > 0 ? (float)(fix->y / fix->reports) : f->y;
+        double seen = fix->reports > 0 ? fix->newest : feed->lastSeen[i];
+        double dt = isfinite(seen) ? feed->clock - seen : 0;
+        tree->predictedX[i] = x + f->velocityX * dt;
+        tree->predictedY[i] = y + f->velocityY * dt;
+        tree->order[i] = i;
+    }
+    buildTrackTree(tree, 0, tree->count, 0);
+    tree->predictedAt = feed->clock;
+}
+
+void nearestTrack(const TrackTree* tree, int lo, int hi, int axis, float x, float y, int* best, float* bestDistance2) {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+    int i = tree->order[mid];
+    float dx = x - tree->predictedX[i];
+    float dy = y - tree->predictedY[i];
+    float distance2 = dx * dx + dy * dy;
+    if (distance2 < *bestDistance2) {
+        *bestDistance2 = distance2;
+        *best = i;
+    }
+    float split = axis ? dy : dx;
+    if (split < 0) {
+        nearestTrack(tree, lo, mid, !axis, x, y, best, bestDistance2);
+        if (split * split < *bestDistance2) nearestTrack(tree, mid + 1, hi, !axis, x, y, best, bestDistance2);
+    } else {
+        nearestTrack(tree, mid + 1, hi, !axis, x, y, best, bestDistance2);
+        if (split * split < *bestDistance2) nearestTrack(tree, lo, mid, !axis, x, y, best, bestDistance2);
+    }
+}
+
+// Returns the flight index of the nearest predicted track within the gate, or -1.
+int associateReport(RadarFeed* feed, float x, float y) {
+    if (!(feed->clock - feed->tree.predictedAt <= RADAR_FUSE_WINDOW)) predictTracks(feed);
+    int best = -1;
+    float bestDistance2 = radarGate * radarGate;
+    nearestTrack(&feed->tree, 0, feed->tree.count, 0, x, y, &best, &bestDistance2);
+    return best;
+}
+
+// Moves the flight to its fused fix, updates the velocity estimate the
+// predictions use and runs the envelope checks.
+void applyRadarFix(RadarFeed* feed, int i) {
+    RadarFix* fix = &feed->fixes[i];
+    Flight* f = &feed->flights[i];
+    float x = (float)(fix->x / fix->reports);
+    float y = (float)(fix->y / fix->reports);
+    double dt = fix->newest - feed->lastSeen[i];
+    if (isfinite(dt) && dt > 0) {
+        f->velocityX = (float)((x - f->x) / dt);
+        f->velocityY = (float)((y - f->y) / dt);
+    }
+    feed->fused += fix->reports - 1;
+    feed->lastSeen[i] = fix->newest;
+    f->x = x;
+    f->y = y;
+    f->altitude = (int)(fix->altitude / fix->reports);
+    f->speed = (int)(fix->speed / fix->reports);
+    f->lastUpdated = (time_t)fix->newest;
+    if (f->sprite) sfSprite_setPosition(f->sprite, (sfVector2f){f->x, f->y});
+    fix->reports = 0;
+    char violation_msg[MAX_VIOLATION_MSG];
+    if (checkForViolations(f, violation_msg, sizeof(violation_msg))) feed->violations++;
+}
+
+void flushRadarFixes(RadarFeed* feed) {
+    for (int n = 0; n < feed->pendingCount; n++) {
+        int i = feed->pending[n];
+        feed->fixes[i].queued = false;
+        if (feed->fixes[i].reports > 0) applyRadarFix(feed, i);
+    }
+    feed->pendingCount = 0;
+    feed->tree.predictedAt = NAN;
+}
+
+// Parses a decimal field ending at the next comma or at end, and steps past it.
+bool parseRadarNumber(const char** cursor, const char* end, double* out) {
+    const char* p = *cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    double value = 0;
+    bool digits = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, scale *= 0.1) {
+            value += (*p - '0') * scale;
+            digits = true;
+        }
+    }
+    if (!digits || (p < end && *p != ',')) return false;
+    *cursor = p < end ? p + 1 : p;
+    *out = negative ? -value : value;
+    return true;
+}
+
+void ingestRadarReport(RadarFeed* feed, const char* line, const char* end) {
+    if (end > line && end[-1] == '\r') end--;
+    if (line == end || *line == '#') return;
+    feed->reports++;
+    const char* comma = memchr(line, ',', end - line);
+    double x, y, altitude, speed, timestamp;
+    const char* p = comma ? comma + 1 : end;
+    if (!comma || !parseRadarNumber(&p, end, &x) || !parseRadarNumber(&p, end, &y) ||
+        !parseRadarNumber(&p, end, &altitude) || !parseRadarNumber(&p, end, &speed) ||
+        !parseRadarNumber(&p, end, &timestamp) || p != end) {
+        feed->malformed++;
+        return;
+    }
+    if (timestamp > feed->clock) feed->clock = timestamp;
+    int i;
+    if (comma == line) {
+        i = associateReport(feed, (float)x, (float)y);
+        if (i < 0) {
+            feed->unassociated++;
+            return;
+        }
+    } else {
+        Flight* f = findIndexedFlight(&feed->index, feed->flights, line, comma - line);
+        if (!f) {
+            feed->unknown++;
+            return;
+        }
+        i = f - feed->flights;
+    }
+    RadarFix* fix = &feed->fixes[i];
+    if (timestamp < feed->lastSeen[i] || (fix->reports > 0 && timestamp < fix->newest - RADAR_FUSE_WINDOW)) {
+        feed->stale++;
+        return;
+    }
+    if (comma == line) feed->associated++;
+    else feed->matched++;
+    if (fix->reports > 0 && timestamp > fix->newest + RADAR_FUSE_WINDOW) applyRadarFix(feed, i);
+    if (!fix->queued) {
+        fix->queued = true;
+        feed->pending[feed->pendingCount++] = i;
+    }
+    if (fix->reports == 0) {
+        fix->x = fix->y = fix->altitude = fix->speed = 0;
+        fix->newest = timestamp;
+    }
+    fix->x += x;
+    fix->y += y;
+    fix->altitude += altitude;
+    fix->speed += speed;
+    if (timestamp > fix->newest) fix->newest = timestamp;
+    fix->reports++;
+}
+
+// Runs every complete line in data through the feed, holding the flight data
+// lock for RADAR_BATCH reports at a time. With final a trailing line without
+// a newline counts too. Returns the number of bytes consumed.
+size_t ingestRadarBuffer(RadarFeed* feed, const char* data, size_t size, bool final) {
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        long before = feed->reports;
+        lockFlightData();
+        for (int n = 0; n < RADAR_BATCH && p < end; n++) {
+            const char* newline = memchr(p, '\n', end - p);
+            if (!newline && !final) break;
+            const char* lineEnd = newline ? newline : end;
+            ingestRadarReport(feed, p, lineEnd);
+            p = newline ? newline + 1 : end;
+        }
+        flushRadarFixes(feed);
+        unlockFlightData();
+        atomic_fetch_add_explicit(&counters[COUNTER_RADAR_REPORTS], feed->reports - before, memory_order_relaxed);
+        if (p < end && !final && !memchr(p, '\n', end - p)) break;
+    }
+    return p - data;
+}
+
+bool ingestRadarFile(RadarFeed* feed, const char* path) {
+    feed->started = monotonicNs();
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Failed to open radar recording");
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Failed to map radar recording");
+        return false;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    ingestRadarBuffer(feed, data, st.st_size, true);
+    munmap(data, st.st_size);
+    return true;
+}
+
+// Stand-in for a live surveillance link: waits for one feeder to connect and
+// reads until it hangs up. Partial lines are carried over to the next read.
+bool ingestRadarSocket(RadarFeed* feed, const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 1) < 0) {
+        perror("Failed to listen for radar feed");
+        if (listenFd >= 0) close(listenFd);
+        return false;
+    }
+    printf("Waiting for a radar feed on %s\n", path);
+    fflush(stdout);
+    int fd = accept(listenFd, NULL, NULL);
+    close(listenFd);
+    unlink(path);
+    char* buffer = malloc(RADAR_BUFFER_SIZE);
+    if (fd < 0 || !buffer) {
+        perror("Failed to accept radar feed");
+        if (fd >= 0) close(fd);
+        free(buffer);
+        return false;
+    }
+    feed->started = monotonicNs();
+    size_t filled = 0;
+    while (1) {
+        ssize_t got = read(fd, buffer + filled, RADAR_BUFFER_SIZE - filled);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        filled += got;
+        size_t used = ingestRadarBuffer(feed, buffer, filled, false);
+        if (used == 0 && filled == RADAR_BUFFER_SIZE) {
+            // A line longer than the whole buffer: drop it as malformed.
+            feed->reports++;
+            feed->malformed++;
+            used = filled;
+        }
+        memmove(buffer, buffer + used, filled - used);
+        filled -= used;
+    }
+    ingestRadarBuffer(feed, buffer, filled, true);
+    close(fd);
+    free(buffer);
+    return true;
+}
+
+int runRadarIngest(const char* source, Flight* flights, int flightCount) {
+    RadarFeed feed = { 0 };
+    feed.flights = flights;
+    size_t tracks = flightCount > 0 ? flightCount : 1;
+    feed.lastSeen = malloc(sizeof(double) * tracks);
+    feed.fixes = calloc(tracks, sizeof(RadarFix));
+    feed.pending = malloc(sizeof(int32_t) * tracks);
+    feed.tree.order = malloc(sizeof(int32_t) * tracks);
+    feed.tree.predictedX = malloc(sizeof(float) * tracks);
+    feed.tree.predictedY = malloc(sizeof(float) * tracks);
+    feed.tree.count = flightCount;
+    feed.clock = -INFINITY;
+    feed.tree.predictedAt = NAN;
+    bool ready = feed.lastSeen && feed.fixes && feed.pending && feed.tree.order && feed.tree.predictedX &&
+                 feed.tree.predictedY && buildFlightIndex(&feed.index, flights, flightCount);
+    if (ready) for (int i = 0; i < flightCount; i++) feed.lastSeen[i] = -INFINITY;
+    bool ok = ready && (strncmp(source, "unix:", 5) == 0 ? ingestRadarSocket(&feed, source + 5)
+                                                         : ingestRadarFile(&feed, source));
+    uint64_t elapsed = monotonicNs() - feed.started;
+    free(feed.index.slots);
+    free(feed.lastSeen);
+    free(feed.fixes);
+    free(feed.pending);
+    free(feed.tree.order);
+    free(feed.tree.predictedX);
+    free(feed.tree.predictedY);
+    if (!ready) perror("Failed to build flight index");
+    if (!ok) return 1;
+    printf("Ingested %ld radar reports for %d flights in %.3f ms (%.0f reports/s)\n", feed.reports, flightCount,
+           elapsed / 1e6, elapsed ? feed.reports * 1e9 / elapsed : 0.0);
+    printf("Matched: %ld | Associated: %ld | Unassociated: %ld | Fused: %ld | Unknown: %ld | Stale: %ld | "
+           "Malformed: %ld | Violations: %ld\n", feed.matched, feed.associated, feed.unassociated, feed.fused,
+           feed.unknown, feed.stale, feed.malformed, feed.violations);
+    displayActiveViolations(flights, flightCount);
+    return 0;
+}
+
+// Checkpoint and restore. The snapshot file is a header followed by two
+// slots; each snapshot goes into the slot not holding the latest one and only
+// becomes valid once its generation is stamped, so a crash mid-write leaves
+// the previous snapshot intact. Simulation threads are paused only for the
+// copy into the mapped slot; the kernel writes it back in the background.
+#define SNAPSHOT_MAGIC "ATCSNP1"
+#define SNAPSHOT_VERSION 5
+#define SNAPSHOT_HEADER_BYTES 4096
+#define DEFAULT_SNAPSHOT_INTERVAL_MS 500
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flightSize;
+    uint32_t maxFlights;
+    uint32_t lifecycleSize;
+    uint64_t slotBytes;
+} SnapshotHeader;
+
+typedef struct {
+    _Atomic uint64_t generation;   // 0 while the slot is being written
+    uint64_t seed;
+    RngStream controlRng;
+    int64_t simulationElapsed;
+    uint32_t traceSequence;
+    int32_t flightCount;
+    int32_t runwayCount;
+    int32_t queueCount[MAX_RUNWAYS];
+    int32_t airlineCount;
+    int32_t airlineActive[MAX_AIRLINES];
+    int32_t lifecycleCount;        // 0 when taken outside a simulation run
+} SnapshotSlot;
+
+typedef struct {
+    unsigned char* base;
+    size_t length;
+    int fd;
+} SnapshotFile;
+
+SnapshotFile snapshotFile = { NULL, 0, -1 };
+int snapshotIntervalMs = DEFAULT_SNAPSHOT_INTERVAL_MS;
+uint64_t snapshotGeneration = 0;
+ThreadData* snapshotData = NULL;
+Airline* snapshotAirlines = NULL;
+pthread_t snapshotThreadId;
+atomic_bool snapshotRunning;
+
+size_t snapshotFlightsOffset() {
+    return (sizeof(SnapshotSlot) + 63) & ~(size_t)63;
+}
+
+size_t snapshotQueuesOffset() {
+    return snapshotFlightsOffset() + sizeof(Flight) * MAX_FLIGHTS;
+}
+
+size_t snapshotLifecyclesOffset() {
+    return snapshotQueuesOffset() + sizeof(int32_t) * MAX_RUNWAYS * MAX_FLIGHTS;
+}
+
+size_t snapshotSlotBytes() {
+    size_t bytes = snapshotLifecyclesOffset() + sizeof(SnapshotLifecycle) * MAX_FLIGHTS;
+    return (bytes + 4095) & ~(size_t)4095;
+}
+
+SnapshotSlot* snapshotSlotAt(unsigned char* base, int index) {
+    return (SnapshotSlot*)(base + SNAPSHOT_HEADER_BYTES + snapshotSlotBytes() * index);
+}
+
+// Slot holding the newest complete snapshot, or -1 when there is none.
+int latestSnapshotSlot(unsigned char* base) {
+    uint64_t g0 = atomic_load(&snapshotSlotAt(base, 0)->generation);
+    uint64_t g1 = atomic_load(&snapshotSlotAt(base, 1)->generation);
+    if (g0 == 0 && g1 == 0) return -1;
+    return g1 > g0 ? 1 : 0;
+}
+
+bool snapshotHeaderMatches(const SnapshotHeader* h) {
+    return memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) == 0 && h->version == SNAPSHOT_VERSION &&
+           h->flightSize == sizeof(Flight) && h->maxFlights == MAX_FLIGHTS &&
+           h->lifecycleSize == sizeof(SnapshotLifecycle) && h->slotBytes == snapshotSlotBytes();
+}
+
+// Maps a snapshot file. A writable mapping creates or re-initialises the file
+// when its layout does not match this build; a read-only one rejects it.
+bool mapSnapshotFile(const char* path, bool writable, SnapshotFile* out) {
+    size_t length = SNAPSHOT_HEADER_BYTES + 2 * snapshotSlotBytes();
+    int fd = writable ? open(path, O_RDWR | O_CREAT, 0644) : open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open snapshot file");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("Failed to stat snapshot file");
+        close(fd);
+        return false;
+    }
+    if ((size_t)st.st_size != length) {
+        if (!writable) {
+            fprintf(stderr, "%s is not a snapshot from this build\n", path);
+            close(fd);
+            return false;
+        }
+        if (ftruncate(fd, (off_t)length) < 0) {
+            perror("Failed to size snapshot file");
+            close(fd);
+            return false;
+        }
+    }
+    void* base = mmap(NULL, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("Failed to map snapshot file");
+        close(fd);
+        return false;
+    }
+    SnapshotHeader* header = base;
+    if (!snapshotHeaderMatches(header)) {
+        if (!writable) {
+            fprintf(stderr, "%s is not a snapshot from this build\n", path);
+            munmap(base, length);
+            close(fd);
+            return false;
+        }
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+        header->version = SNAPSHOT_VERSION;
+        header->flightSize = sizeof(Flight);
+        header->maxFlights = MAX_FLIGHTS;
+        header->lifecycleSize = sizeof(SnapshotLifecycle);
+        header->slotBytes = snapshotSlotBytes();
+        atomic_store(&snapshotSlotAt(base, 0)->generation, 0);
+        atomic_store(&snapshotSlotAt(base, 1)->generation, 0);
+    }
+    out->base = base;
+    out->length = length;
+    out->fd = fd;
+    return true;
+}
+
+void unmapSnapshotFile(SnapshotFile* file) {
+    if (!file->base) return;
+    munmap(file->base, file->length);
+    close(file->fd);
+    file->base = NULL;
+    file->fd = -1;
+}
+
+// Copies the active lifecycles; caller holds every scheduler lock with the
+// schedulers paused and idle.
+int snapshotLifecycles(SnapshotLifecycle* out, Flight* store, double now) {
+    for (int i = 0; i < activeLifecycleCount; i++) {
+        FlightLifecycle* lc = &activeLifecycles[i];
+        SnapshotLifecycle* s = &out[i];
+        s->flightIndex = (int32_t)(lc->flight - store);
+        s->state = (int8_t)lc->state;
+        s->step = (int8_t)lc->step;
+        s->runwayIndex = (int8_t)lc->runwayIndex;
+        s->flags = lc->plan == departurePlan ? SNAPSHOT_LC_DEPARTURE : 0;
+        if (lc->groundBooked) s->flags |= SNAPSHOT_LC_GROUND_BOOKED;
+        for (int k = 0; k < GROUND_KINDS; k++) {
+            s->groundResource[k] = (int8_t)lc->ground[k].resource;
+            s->groundStartIn[k] = (float)(lc->ground[k].start - now);
+            s->groundEndIn[k] = (float)(lc->ground[k].end - now);
+        }
+        s->waitRank = 0;
+        s->phaseElapsed = (float)lc->phaseElapsed;
+        s->wakeIn = lc->wakeTime > now ? (float)(lc->wakeTime - now) : 0;
+    }
+    for (int r = 0; r < runwayCount; r++) {
+        pthread_mutex_lock(&runwayLocks[r]);
+        RunwaySlot* slot = &runwaySlots[r];
+        if (slot->owner) out[slot->owner - activeLifecycles].flags |= SNAPSHOT_LC_OWNS_RUNWAY;
+        int rank = 1;
+        for (FlightLifecycle* w = slot->waitHead; w; w = w->nextWaiter) {
+            out[w - activeLifecycles].waitRank = rank++;
+        }
+        pthread_mutex_unlock(&runwayLocks[r]);
+    }
+    return activeLifecycleCount;
+}
+
+// The store is copied in two passes so the workers only stop for flights
+// that moved during the copy. The bulk pass runs alongside them; every
+// lifecycle that finishes a resume after it starts carries the new epoch, and
+// only those flights, plus any added since, are copied again while the
+// schedulers are paused.
+void takeSnapshot() {
+    int latest = latestSnapshotSlot(snapshotFile.base);
+    SnapshotSlot* slot = snapshotSlotAt(snapshotFile.base, latest == 0 ? 1 : 0);
+    unsigned char* payload = (unsigned char*)slot;
+    Flight* flights = (Flight*)(payload + snapshotFlightsOffset());
+    int32_t* queues = (int32_t*)(payload + snapshotQueuesOffset());
+    SnapshotLifecycle* lifecycles = (SnapshotLifecycle*)(payload + snapshotLifecyclesOffset());
+    atomic_store(&slot->generation, 0);
+
+    uint64_t epoch = atomic_fetch_add(&snapshotEpoch, 1) + 1;
+    // A resume that finished before its scheduler lock is taken here is
+    // visible to the bulk copy; any later one reads the new epoch.
+    for (int i = 0; i < schedulerCount; i++) {
+        pthread_mutex_lock(&schedulers[i].lock);
+        pthread_mutex_unlock(&schedulers[i].lock);
+    }
+    Flight* store = snapshotData->flights;
+    lockFlightData();
+    int copied = snapshotData->flightCount;
+    unlockFlightData();
+    memcpy(flights, store, sizeof(Flight) * copied);
+
+    uint64_t pauseStart = monotonicNs();
+    for (int i = 0; i < schedulerCount; i++) {
+        LifecycleScheduler* s = &schedulers[i];
+        pthread_mutex_lock(&s->lock);
+        s->paused = true;
+        while (s->running > 0) pthread_cond_wait(&s->wake, &s->lock);
+    }
+    lockFlightData();
+    int count = snapshotData->flightCount;
+    for (int i = 0; i < activeLifecycleCount; i++) {
+        FlightLifecycle* lc = &activeLifecycles[i];
+        int index = (int)(lc->flight - store);
+        if (lc->snapshotEpoch == epoch && index < copied && index < count) flights[index] = *lc->flight;
+    }
+    if (count > copied) memcpy(flights + copied, store + copied, sizeof(Flight) * (count - copied));
+    slot->runwayCount = runwayCount;
+    for (int r = 0; r < runwayCount; r++) {
+        slot->queueCount[r] = runways[r].queueCount;
+        for (int k = 0; k < runways[r].queueCount; k++) {
+            queues[r * MAX_FLIGHTS + k] = (int32_t)(runways[r].queue[k] - store);
+        }
+    }
+    slot->airlineCount = airlineCount;
+    for (int a = 0; a < airlineCount; a++) slot->airlineActive[a] = snapshotAirlines[a].activeFlights;
+    slot->seed = scenarioSeed;
+    slot->controlRng = controlRng;
+    slot->simulationElapsed = (int64_t)(time(NULL) - simulationStartTime);
+    slot->traceSequence = atomic_load(&nextTraceSequence);
+    slot->flightCount = count;
+    slot->lifecycleCount = snapshotLifecycles(lifecycles, store, monotonicSeconds());
+    unlockFlightData();
+    for (int i = schedulerCount - 1; i >= 0; i--) {
+        schedulers[i].paused = false;
+        pthread_cond_broadcast(&schedulers[i].wake);
+        pthread_mutex_unlock(&schedulers[i].lock);
+    }
+    recordLatency(METRIC_SNAPSHOT_PAUSE, monotonicNs() - pauseStart);
+    for (int i = 0; i < count; i++) flights[i].sprite = NULL;
+
+    atomic_store_explicit(&slot->generation, ++snapshotGeneration, memory_order_release);
+    msync(slot, snapshotSlotBytes(), MS_ASYNC);
+    countEvent(COUNTER_SNAPSHOTS);
+}
+
+void* snapshotThread(void* arg) {
+    (void)arg;
+    while (atomic_load(&snapshotRunning)) {
+        for (int waited = 0; waited < snapshotIntervalMs && atomic_load(&snapshotRunning); waited += 10) {
+            usleep(10000);
+        }
+        if (atomic_load(&snapshotRunning)) takeSnapshot();
+    }
+    return NULL;
+}
+
+bool snapshotInit(const char* path, ThreadData* data, Airline airlines[]) {
+    if (!mapSnapshotFile(path, true, &snapshotFile)) return false;
+    uint64_t g0 = atomic_load(&snapshotSlotAt(snapshotFile.base, 0)->generation);
+    uint64_t g1 = atomic_load(&snapshotSlotAt(snapshotFile.base, 1)->generation);
+    snapshotGeneration = g0 > g1 ? g0 : g1;
+    snapshotData = data;
+    snapshotAirlines = airlines;
+    atomic_store(&snapshotRunning, true);
+    if (pthread_create(&snapshotThreadId, NULL, snapshotThread, NULL) != 0) {
+        perror("Failed to start snapshot thread");
+        atomic_store(&snapshotRunning, false);
+        unmapSnapshotFile(&snapshotFile);
+        return false;
+    }
+    return true;
+}
+
+// Stops periodic snapshots. No final one is taken: by now the run is over
+// and its flights may already be cleared, so the last periodic snapshot
+// stays the one a restart resumes from.
+void snapshotShutdown() {
+    if (!atomic_load(&snapshotRunning)) return;
+    atomic_store(&snapshotRunning, false);
+    pthread_join(snapshotThreadId, NULL);
+    msync(snapshotFile.base, snapshotFile.length, MS_SYNC);
+    unmapSnapshotFile(&snapshotFile);
+}
+
+void restoreFlightSprite(Flight* f) {
+    f->sprite = sfSprite_create();
+    if (!f->sprite) return;
+    sfSprite_setTexture(f->sprite, textureForFlight(f), sfTrue);
+    sfSprite_setRotation(f->sprite, (f->direction == NORTH || f->direction == EAST) ? 180.0f : 0);
+    sfSprite_setPosition(f->sprite, (sfVector2f){f->x, f->y});
+    sfSprite_setScale(f->sprite, (sfVector2f){0.5f, 0.5f});
+}
+
+// Loads the newest snapshot into the flight store, runway queues, airline
+// table and RNG state. Returns how many lifecycles were in progress (their
+// copies are handed back through lifecyclesOut) or -1 on error.
+int restoreSnapshot(const char* path, Airline airlines[], Flight* flights, int* flightCount,
+                    SnapshotLifecycle** lifecyclesOut) {
+    uint64_t start = monotonicNs();
+    SnapshotFile file;
+    if (!mapSnapshotFile(path, false, &file)) return -1;
+    int latest = latestSnapshotSlot(file.base);
+    if (latest < 0) {
+        fprintf(stderr, "%s holds no complete snapshot\n", path);
+        unmapSnapshotFile(&file);
+        return -1;
+    }
+    SnapshotSlot* slot = snapshotSlotAt(file.base, latest);
+    uint64_t generation = atomic_load_explicit(&slot->generation, memory_order_acquire);
+    unsigned char* payload = (unsigned char*)slot;
+    int count = slot->flightCount;
+    int lifecycleCount = slot->lifecycleCount;
+    if (count < 0 || count > MAX_FLIGHTS || lifecycleCount < 0 || lifecycleCount > count) {
+        fprintf(stderr, "%s: corrupt snapshot\n", path);
+        unmapSnapshotFile(&file);
+        return -1;
+    }
+    if (slot->runwayCount != runwayCount) {
+        fprintf(stderr, "%s was taken with %d runways, this configuration has %d\n", path, slot->runwayCount,
+                runwayCount);
+        unmapSnapshotFile(&file);
+        return -1;
+    }
+    if (slot->airlineCount != airlineCount) {
+        fprintf(stderr, "%s was taken with %d airlines, this registry has %d\n", path, slot->airlineCount,
+                airlineCount);
+        unmapSnapshotFile(&file);
+        return -1;
+    }
+    const int32_t* queues = (const int32_t*)(payload + snapshotQueuesOffset());
+    const SnapshotLifecycle* lifecycles = (const SnapshotLifecycle*)(payload + snapshotLifecyclesOffset());
+    for (int r = 0; r < runwayCount; r++) {
+        if (slot->queueCount[r] < 0 || slot->queueCount[r] > count) count = -1;
+        for (int k = 0; count >= 0 && k < slot->queueCount[r]; k++) {
+            if (queues[r * MAX_FLIGHTS + k] < 0 || queues[r * MAX_FLIGHTS + k] >= count) count = -1;
+        }
+    }
+    for (int i = 0; count >= 0 && i < lifecycleCount; i++) {
+        if (lifecycles[i].flightIndex < 0 || lifecycles[i].flightIndex >= count ||
+            lifecycles[i].runwayIndex < -1 || lifecycles[i].runwayIndex >= runwayCount ||
+            lifecycles[i].state < LC_SCHEDULED || lifecycles[i].state > LC_DONE) count = -1;
+    }
+    if (count < 0) {
+        fprintf(stderr, "%s: corrupt snapshot\n", path);
+        unmapSnapshotFile(&file);
+        return -1;
+    }
+    SnapshotLifecycle* restored = NULL;
+    if (lifecycleCount > 0) {
+        restored = malloc(sizeof(SnapshotLifecycle) * lifecycleCount);
+        if (!restored) {
+            perror("Failed to allocate restored lifecycles");
+            unmapSnapshotFile(&file);
+            return -1;
+        }
+        memcpy(restored, lifecycles, sizeof(SnapshotLifecycle) * lifecycleCount);
+    }
+
+    lockFlightData();
+    memcpy(flights, payload + snapshotFlightsOffset(), sizeof(Flight) * count);
+    for (int r = 0; r < runwayCount; r++) {
+        for (int k = 0; k < slot->queueCount[r]; k++) runways[r].queue[k] = &flights[queues[r * MAX_FLIGHTS + k]];
+        runways[r].queueCount = slot->queueCount[r];
+    }
+    if (!headless) {
+        bool* done = calloc(count > 0 ? count : 1, sizeof(bool));
+        for (int i = 0; done && i < lifecycleCount; i++) {
+            if (restored[i].state == LC_DONE) done[restored[i].flightIndex] = true;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!done || !done[i]) restoreFlightSprite(&flights[i]);
+        }
+        free(done);
+    }
+    for (int i = 0; i < count; i++) noteFlightChanged(&flights[i]);
+    *flightCount = count;
+    unlockFlightData();
+    for (int a = 0; a < airlineCount; a++) airlines[a].activeFlights = slot->airlineActive[a];
+    scenarioSeed = slot->seed;
+    controlRng = slot->controlRng;
+    simulationStartTime = time(NULL) - (time_t)slot->simulationElapsed;
+    atomic_store(&nextTraceSequence, slot->traceSequence);
+    unmapSnapshotFile(&file);
+
+    *lifecyclesOut = restored;
+    printf("Restored %d flights (%d lifecycles, seed %llu) from snapshot generation %llu in %.2f ms\n",
+           count, lifecycleCount, (unsigned long long)scenarioSeed, (unsigned long long)generation,
+           (monotonicNs() - start) / 1e6);
+    return lifecycleCount;
+}
+
+// What-if lookahead. Each candidate decision is tried in a forked copy of the
+// simulator, so the copy-on-write fork is the snapshot. The copy runs the
+// whole schedule on the virtual clock with AVN output off and reports its
+// outcome over a pipe; the parent commits the cheapest candidate. Per-flight
+// RNG streams make every candidate see the same speeds and positions.
+//
+// Copies are only forked from a process with no other threads, where no lock
+// can be left held by a thread the child lacks: a replica or PDES child, or
+// otherwise the lookahead helper, forked in main before any thread starts.
+// The live simulator hands the helper its flights and runway queues through
+// a shared mapping and waits for the results.
+#define MAX_LOOKAHEAD_CANDIDATES 16
+
+typedef enum { LOOKAHEAD_GREEDY, LOOKAHEAD_FCFS, LOOKAHEAD_SHIFT } LookaheadKind;
+
+typedef struct {
+    LookaheadKind kind;
+    Runway from;
+    int count;
+} LookaheadCandidate;
+
+typedef struct {
+    RunOutcome outcome;
+    int violations;
+    bool completed;
+} LookaheadResult;
+
+typedef struct {
+    uint64_t seed;
+    int flightCount;
+    int candidateCount;
+    int queueCount[MAX_RUNWAYS];
+    LookaheadCandidate candidates[MAX_LOOKAHEAD_CANDIDATES];
+    LookaheadResult results[MAX_LOOKAHEAD_CANDIDATES];
+    int32_t queues[MAX_RUNWAYS][MAX_FLIGHTS];
+    Flight flights[MAX_FLIGHTS];
+} LookaheadRequest;
+
+int lookaheadCandidates = 0;
+LookaheadRequest* lookaheadRequest = NULL;   // shared with the helper
+pid_t lookaheadHelper = -1;
+bool lookaheadForkDirect = false;   // set in replica and PDES children, which have no threads
+int lookaheadCommandFd = -1;   // one byte per request to the helper
+int lookaheadReplyFd = -1;     // one byte back once its results are in
+
+int ScheduledTimeComparison(const void* a, const void* b) {
+    Flight* f1 = *(Flight**)a;
+    Flight* f2 = *(Flight**)b;
+    if (f1->scheduledTime != f2->scheduledTime) return f1->scheduledTime - f2->scheduledTime;
+    return strcmp(f1->id, f2->id);
+}
+
+// Moves the last count flights of a runway's queue onto the fallback runway.
+void shiftToFallback(Runway from, int count) {
+    Runway to = fallbackRunway();
+    RunwayConfig* src = &runways[from];
+    RunwayConfig* dst = &runways[to];
+    while (count-- > 0 && src->queueCount > 0) {
+        Flight* f = src->queue[--src->queueCount];
+        f->assignedRunway = to;
+        placeOnRunway(f, to);
+        dst->queue[dst->queueCount++] = f;
+    }
+    sortQueue(dst->queue, dst->queueCount);
+}
+
+void applyLookaheadCandidate(const LookaheadCandidate* c) {
+    switch (c->kind) {
+        case LOOKAHEAD_GREEDY:
+            break;
+        case LOOKAHEAD_FCFS:
+            for (int r = 0; r < runwayCount; r++) {
+                qsort(runways[r].queue, runways[r].queueCount, sizeof(Flight*), ScheduledTimeComparison);
+            }
+            break;
+        case LOOKAHEAD_SHIFT:
+            shiftToFallback(c->from, c->count);
+            break;
+    }
+    FindWaitTime();
+}
+
+void describeLookaheadCandidate(const LookaheadCandidate* c, char* out, size_t size) {
+    switch (c->kind) {
+        case LOOKAHEAD_GREEDY: snprintf(out, size, "greedy"); break;
+        case LOOKAHEAD_FCFS: snprintf(out, size, "first-come-first-served"); break;
+        case LOOKAHEAD_SHIFT:
+            snprintf(out, size, "move %d from %s to %s", c->count, runways[c->from].name,
+                     runways[fallbackRunway()].name);
+            break;
+    }
+}
+
+int buildLookaheadCandidates(LookaheadCandidate* out, int max) {
+    if (max > MAX_LOOKAHEAD_CANDIDATES) max = MAX_LOOKAHEAD_CANDIDATES;
+    int n = 0;
+    Runway fallback = fallbackRunway();
+    out[n++] = (LookaheadCandidate){LOOKAHEAD_GREEDY, NO_RUNWAY, 0};
+    if (n < max) out[n++] = (LookaheadCandidate){LOOKAHEAD_FCFS, NO_RUNWAY, 0};
+    for (int k = 1; n < max; k++) {
+        bool any = false;
+        for (int r = 0; r < runwayCount && n < max; r++) {
+            if (r == fallback || runways[r].queueCount < k) continue;
+            out[n++] = (LookaheadCandidate){LOOKAHEAD_SHIFT, r, k};
+            any = true;
+        }
+        if (!any) break;
+    }
+    return n;
+}
+
+// Lower is better: runway delay, with emergencies and AVN notices weighted up.
+double lookaheadCost(const LookaheadResult* r) {
+    return r->outcome.totalWait + 3.0 * r->outcome.emergencyWait + 60.0 * r->violations;
+}
+
+void runLookaheadChild(Flight* flights, int flightCount, const LookaheadCandidate* c, int fd) {
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
     }
-    printf("================================\n");
-    printf("\033[0m");
+    logLevel = LOG_OFF;
+    traceFile = NULL;
+    avnOutputEnabled = false;
+    headless = true;
+    virtualClock = true;
+    virtualNow = 0;
+    applyLookaheadCandidate(c);
+    simulationRunning = true;
+    runFlightLifecycles(flights, NULL, 0);
+    LookaheadResult r = { 0 };
+    r.outcome = runOutcome;
+    for (int i = 0; i < flightCount; i++) r.violations += flights[i].avnCount;
+    r.completed = true;
+    write(fd, &r, sizeof(r));
+    close(fd);
+    _exit(0);
 }
 
-void logS(Flight* flights, int flightCount) {
-    FILE* logFile = fopen("simulation_log.txt", "a");
-    if (!logFile) {
-        perror("Failed to open log file");
+// Forks one copy per candidate and collects their projections; a candidate
+// whose copy failed comes back not completed. The caller has no other threads.
+void forkLookaheadCandidates(Flight* flights, int flightCount, const LookaheadCandidate* candidates, int n,
+                             LookaheadResult* results) {
+    pid_t pids[MAX_LOOKAHEAD_CANDIDATES];
+    int fds[MAX_LOOKAHEAD_CANDIDATES];
+    fflush(stdout);
+    for (int i = 0; i < n; i++) {
+        pids[i] = -1;
+        fds[i] = -1;
+        int p[2];
+        if (pipe(p) < 0) continue;
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(p[0]);
+            for (int j = 0; j < i; j++) {
+                if (fds[j] >= 0) close(fds[j]);
+            }
+            runLookaheadChild(flights, flightCount, &candidates[i], p[1]);
+        }
+        close(p[1]);
+        if (pid < 0) {
+            perror("Failed to fork lookahead");
+            close(p[0]);
+            continue;
+        }
+        pids[i] = pid;
+        fds[i] = p[0];
+    }
+    for (int i = 0; i < n; i++) {
+        LookaheadResult r = { 0 };
+        if (fds[i] >= 0) {
+            size_t got = 0;
+            while (got < sizeof(r)) {
+                ssize_t k = read(fds[i], (char*)&r + got, sizeof(r) - got);
+                if (k <= 0) break;
+                got += (size_t)k;
+            }
+            if (got != sizeof(r)) r.completed = false;
+            close(fds[i]);
+        }
+        if (pids[i] > 0) waitpid(pids[i], NULL, 0);
+        results[i] = r;
+    }
+}
+
+// The helper's loop: for each request, load the shipped flights and queues
+// into its own copy of the store and fork the candidates from there.
+void runLookaheadHelper(Flight* flights, int commandFd, int replyFd) {
+    LookaheadRequest* q = lookaheadRequest;
+    char command;
+    while (read(commandFd, &command, 1) == 1) {
+        memcpy(flights, q->flights, sizeof(Flight) * q->flightCount);
+        for (int r = 0; r < runwayCount; r++) {
+            runways[r].queueCount = q->queueCount[r];
+            for (int k = 0; k < q->queueCount[r]; k++) runways[r].queue[k] = &flights[q->queues[r][k]];
+        }
+        scenarioSeed = q->seed;
+        forkLookaheadCandidates(flights, q->flightCount, q->candidates, q->candidateCount, q->results);
+        if (write(replyFd, &command, 1) != 1) break;
+    }
+    _exit(0);
+}
+
+// Forks the helper; called from main while the process is still single
+// threaded. Without it lookahead is skipped rather than forked unsafely.
+bool lookaheadInit(Flight* flights) {
+    lookaheadRequest = mmap(NULL, sizeof(LookaheadRequest), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (lookaheadRequest == MAP_FAILED) {
+        perror("Failed to map the lookahead request");
+        lookaheadRequest = NULL;
+        return false;
+    }
+    int command[2], reply[2];
+    if (pipe(command) < 0) {
+        perror("Failed to start the lookahead helper");
+        return false;
+    }
+    if (pipe(reply) < 0) {
+        perror("Failed to start the lookahead helper");
+        close(command[0]);
+        close(command[1]);
+        return false;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(command[1]);
+        close(reply[0]);
+        runLookaheadHelper(flights, command[0], reply[1]);
+    }
+    close(command[0]);
+    close(reply[1]);
+    if (pid < 0) {
+        perror("Failed to start the lookahead helper");
+        close(command[1]);
+        close(reply[0]);
+        return false;
+    }
+    lookaheadHelper = pid;
+    lookaheadCommandFd = command[1];
+    lookaheadReplyFd = reply[0];
+    return true;
+}
+
+void lookaheadShutdown() {
+    if (lookaheadHelper < 0) return;
+    close(lookaheadCommandFd);
+    close(lookaheadReplyFd);
+    waitpid(lookaheadHelper, NULL, 0);
+    lookaheadHelper = -1;
+    munmap(lookaheadRequest, sizeof(LookaheadRequest));
+    lookaheadRequest = NULL;
+}
+
+// Ships the live flights and queues to the helper and waits for its results.
+bool requestLookahead(Flight* flights, int flightCount, const LookaheadCandidate* candidates, int n,
+                      LookaheadResult* results) {
+    LookaheadRequest* q = lookaheadRequest;
+    lockFlightData();
+    memcpy(q->flights, flights, sizeof(Flight) * flightCount);
+    for (int i = 0; i < flightCount; i++) q->flights[i].sprite = NULL;
+    for (int r = 0; r < runwayCount; r++) {
+        q->queueCount[r] = runways[r].queueCount;
+        for (int k = 0; k < runways[r].queueCount; k++) q->queues[r][k] = (int32_t)(runways[r].queue[k] - flights);
+    }
+    unlockFlightData();
+    q->seed = scenarioSeed;
+    q->flightCount = flightCount;
+    q->candidateCount = n;
+    memcpy(q->candidates, candidates, sizeof(LookaheadCandidate) * n);
+    char command = 'L';
+    if (write(lookaheadCommandFd, &command, 1) != 1 || read(lookaheadReplyFd, &command, 1) != 1) {
+        fprintf(stderr, "Lookahead helper is gone\n");
+        return false;
+    }
+    memcpy(results, q->results, sizeof(LookaheadResult) * n);
+    return true;
+}
+
+// Tries each candidate and commits the cheapest one to the live queues.
+void runLookahead(Flight* flights, int flightCount) {
+    LookaheadCandidate candidates[MAX_LOOKAHEAD_CANDIDATES];
+    LookaheadResult results[MAX_LOOKAHEAD_CANDIDATES];
+    int n = buildLookaheadCandidates(candidates, lookaheadCandidates);
+    uint64_t start = monotonicNs();
+    if (lookaheadHelper > 0) {
+        if (!requestLookahead(flights, flightCount, candidates, n, results)) n = 0;
+    } else if (lookaheadForkDirect) {
+        forkLookaheadCandidates(flights, flightCount, candidates, n, results);
+    } else {
+        n = 0;
+    }
+
+    int best = -1;
+    double bestCost = 0;
+    double greedyCost = -1;
+    for (int i = 0; i < n; i++) {
+        if (!results[i].completed) continue;
+        double cost = lookaheadCost(&results[i]);
+        if (candidates[i].kind == LOOKAHEAD_GREEDY) greedyCost = cost;
+        if (best < 0 || cost < bestCost) {
+            best = i;
+            bestCost = cost;
+        }
+    }
+    if (best < 0) {
+        printf("Lookahead failed, keeping the greedy plan\n");
         return;
     }
-    fprintf(logFile, "\n--- Simulation Log ---\n");
-    fprintf(logFile, "Total Flights: %d\n", flightCount);
-    int totalAVNTriggers = 0, totalViolations = 0, emergencyLandings = 0;
+    char name[48];
+    describeLookaheadCandidate(&candidates[best], name, sizeof(name));
+    lockFlightData();
+    applyLookaheadCandidate(&candidates[best]);
+    unlockFlightData();
+    printf("Lookahead tried %d plans in %.1f ms: %s (projected cost %.1f, greedy %.1f)\n",
+           n, (monotonicNs() - start) / 1e6, name, bestCost, greedyCost);
+}
+
+// Puts the runway queues in service order before a run.
+void planQueues(Flight* flights, int flightCount) {
+    for (int r = 0; r < runwayCount; r++) sortQueue(runways[r].queue, runways[r].queueCount);
+    QueuesReordering();
+    FindWaitTime();
+    if (lookaheadCandidates > 1) runLookahead(flights, flightCount);
+}
+
+// Runs the queued flights to completion, or resumes a restored run when
+// restored lifecycles are passed in.
+void runSimulation(Flight* flights, int flightCount, const SnapshotLifecycle* restored, int restoredCount) {
+    if (!restored) {
+        planQueues(flights, flightCount);
+        traceSimulationStart(flights, flightCount);
+    }
+    simulationRunning = true;
+    runFlightLifecycles(flights, restored, restoredCount);
+    simulationRunning = false;
+    closeTrace();
+    logFlush();
+    printf("Ground holds: %d (%.1f s) on %d gates and %d taxiways\n", runOutcome.groundDelays,
+           runOutcome.groundWait, groundPools[GROUND_GATE].count, groundPools[GROUND_TAXIWAY].count);
+    if (sectorsActive()) {
+        printf("Sector handoffs: %llu across %d sectors\n",
+               (unsigned long long)atomic_load(&counters[COUNTER_SECTOR_HANDOFFS]), sectorCount);
+    }
+    if (probe.enabled) {
+        printf("Conflict probe: %llu predicted losses of separation, %llu predicted envelope exits (%.0f s horizon)\n",
+               (unsigned long long)atomic_load(&counters[COUNTER_PREDICTED_CONFLICTS]),
+               (unsigned long long)atomic_load(&counters[COUNTER_PREDICTED_ENVELOPE_EXITS]), probe.horizon);
+    }
+    displayActiveViolations(flights, flightCount);
+    logS(flights, flightCount);
+    printf("Simulation summary logged to 'simulation_log.txt'\n");
+}
+
+void clearFlights(Flight* flights, int flightCount) {
     for (int i = 0; i < flightCount; i++) {
-        int runwayViolation = isRunwayViolation(&flights[i]) ? 1 : 0;
-        fprintf(logFile,
-                "Flight %s | Airline: %s | Type: %s | AVN: %d | Violations: %d | Fuel: %d%%\n",
-                flights[i].id, getAirlineName(flights[i].airlineId),
-                getFlightTypeString(flights[i].type), flights[i].avnCount,
-                runwayViolation, flights[i].fuelLevel);
-        totalAVNTriggers += flights[i].avnCount;
-        totalViolations += runwayViolation;
-        if (flights[i].isEmergency) emergencyLandings++;
-    }
-    fprintf(logFile, "Total AVN Triggers: %d\n", totalAVNTriggers);
-    fprintf(logFile, "Total Violations: %d\n", totalViolations);
-    fprintf(logFile, "Emergency Landings: %d\n", emergencyLandings);
-    fclose(logFile);
+        if (flights[i].sprite) {
+            sfSprite_destroy(flights[i].sprite);
+            flights[i].sprite = NULL;
+        }
+    }
+    memset(flights, 0, sizeof(Flight) * flightCount);
+    clearViolationIndex(flightCount);
+    clearConflictProbe();
+    if (renderTrack.samples) memset(renderTrack.samples, 0, sizeof(RenderSample) * flightCount);
+    for (int r = 0; r < runwayCount; r++) runways[r].queueCount = 0;
 }
 
-void* Flight_ThreadScheduling(void* arg) {
-    Flight* f = (Flight*)arg;
-    if (f->priority == 0) {
-        if (f->isEmergency) f->priority = 2;
-        else if (f->isVIP || f->fuelLevel < FUEL_THRESHOLD + 10) f->priority = 1;
+// Monte Carlo replicas. Each replica is a forked process with its own seed,
+// so it shares no globals with the others; it rebuilds the scenario, runs it
+// on the virtual clock with every output switched off and sends a summary
+// back over a pipe. Replicas run in parallel, up to one per core.
+typedef struct {
+    uint64_t seed;
+    int movements;
+    double hours;
+    double runwayPerHour[MAX_RUNWAYS];
+    double meanWait;
+    double p90Wait;
+    double maxWait;
+    double groundWait;         // mean gate and taxiway hold per movement
+    double emergencyLatency;   // mean emergency wait, negative when none
+    double violationRate;      // AVN notices per movement
+    bool completed;
+} ReplicaResult;
+
+// Metric ids follow one movements-per-hour rate per runway.
+typedef enum {
+    REPLICA_MEAN_WAIT,
+    REPLICA_P90_WAIT,
+    REPLICA_MAX_WAIT,
+    REPLICA_GROUND_WAIT,
+    REPLICA_EMERGENCY_LATENCY,
+    REPLICA_VIOLATION_RATE,
+    REPLICA_METRIC_COUNT
+} ReplicaMetric;
+
+const char* replicaMetricNames[REPLICA_METRIC_COUNT] = {
+    "mean_wait_s", "p90_wait_s", "max_wait_s", "ground_wait_s", "emergency_latency_s", "avn_per_movement"
+};
+
+void replicaMetricName(int m, char* out, size_t size) {
+    if (m < runwayCount) snprintf(out, size, "%.15s_movements_per_hour", runways[m].name);
+    else snprintf(out, size, "%s", replicaMetricNames[m - runwayCount]);
+}
+
+int replicaCount = 0;
+int replicaJobs = 0;
+
+// Two-sided 95% Student t quantile.
+double tQuantile95(int df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) return 0;
+    return df <= 30 ? table[df - 1] : 1.960;
+}
+
+// Value of one metric for a replica; false when the replica has no sample.
+bool replicaMetricValue(const ReplicaResult* r, int m, double* value) {
+    if (m < runwayCount) {
+        *value = r->runwayPerHour[m];
+        return true;
+    }
+    switch ((ReplicaMetric)(m - runwayCount)) {
+        case REPLICA_MEAN_WAIT: *value = r->meanWait; return true;
+        case REPLICA_P90_WAIT: *value = r->p90Wait; return true;
+        case REPLICA_MAX_WAIT: *value = r->maxWait; return true;
+        case REPLICA_GROUND_WAIT: *value = r->groundWait; return true;
+        case REPLICA_EMERGENCY_LATENCY: *value = r->emergencyLatency; return r->emergencyLatency >= 0;
+        case REPLICA_VIOLATION_RATE: *value = r->violationRate; return true;
+        default: return false;
     }
-    printf("\n[Thread] Flight %s scheduled to start in %d seconds (Priority: %d)\n",
-           f->id, f->scheduledTime, f->priority);
-    sleep(f->scheduledTime);
-    RealTimeSimulation(f);
-    pthread_exit(NULL);
 }
 
-void FindWaitTime() {
-    for (int i = 0; i < runwayACount; i++) runwayAQueue[i]->estimatedWait = i * 30;
-    for (int i = 0; i < runwayBCount; i++) runwayBQueue[i]->estimatedWait = i * 30;
-    for (int i = 0; i < runwayCCount; i++) runwayCQueue[i]->estimatedWait = i * 30;
+void runReplica(uint64_t seed, const char* scenarioPath, const char* trafficSpec, Airline airlines[],
+                Flight* flights, int fd) {
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+    logLevel = LOG_OFF;
+    traceFile = NULL;
+    avnOutputEnabled = false;
+    headless = true;
+    lookaheadForkDirect = true;
+    virtualClock = true;
+    virtualNow = 0;
+    scenarioSeed = seed;
+    rngSeed(&controlRng, scenarioSeed, 0);
+    ReplicaResult r = { 0 };
+    r.seed = seed;
+    int flightCount = 0;
+    if (scenarioPath && loadScenarioFile(scenarioPath, airlines, flights, &flightCount) < 0) _exit(1);
+    if (trafficSpec && loadGeneratedTraffic(trafficSpec, NULL, airlines, flights, &flightCount) < 0) _exit(1);
+    waitSampleCapacity = flightCount;
+    waitSamples = malloc(sizeof(double) * (flightCount > 0 ? flightCount : 1));
+    planQueues(flights, flightCount);
+    simulationRunning = true;
+    runFlightLifecycles(flights, NULL, 0);
+    simulationRunning = false;
+
+    int avnNotices = 0;
+    for (int i = 0; i < flightCount; i++) avnNotices += flights[i].avnCount;
+    r.movements = runOutcome.movements;
+    r.hours = runOutcome.finishedAt / 3600.0;
+    for (int i = 0; i < runwayCount; i++) {
+        r.runwayPerHour[i] = r.hours > 0 ? runOutcome.runwayMovements[i] / r.hours : 0;
+    }
+    r.meanWait = r.movements > 0 ? runOutcome.totalWait / r.movements : 0;
+    r.maxWait = runOutcome.maxWait;
+    r.groundWait = r.movements > 0 ? runOutcome.groundWait / r.movements : 0;
+    r.emergencyLatency = runOutcome.emergencies > 0 ? runOutcome.emergencyWait / runOutcome.emergencies : -1;
+    r.violationRate = r.movements > 0 ? (double)avnNotices / r.movements : 0;
+    if (waitSamples && waitSampleCount > 0) {
+        qsort(waitSamples, waitSampleCount, sizeof(double), compareDoubles);
+        int rank = (int)((waitSampleCount * 90 + 99) / 100);
+        r.p90Wait = waitSamples[rank > 0 ? rank - 1 : 0];
+    }
+    r.completed = true;
+    write(fd, &r, sizeof(r));
+    close(fd);
+    _exit(0);
+}
+
+void reportReplicas(FILE* out, const ReplicaResult* results, int count, double elapsedMs, bool json) {
+    int completed = 0;
+    for (int i = 0; i < count; i++) completed += results[i].completed;
+    if (json) {
+        fprintf(out, "{\n  \"seed\": %llu,\n  \"replicas\": %d,\n  \"completed\": %d,\n  \"metrics\": {",
+                (unsigned long long)scenarioSeed, count, completed);
+    } else {
+        printf("\n%d/%d replicas completed in %.0f ms (base seed %llu)\n", completed, count, elapsedMs,
+               (unsigned long long)scenarioSeed);
+        printf("%-26s %5s %10s %10s %10s %10s\n", "Metric", "n", "Mean", "SD", "CI95 low", "CI95 high");
+        printf("----------------------------------------------------------------------------\n");
+    }
+    for (int m = 0; m < runwayCount + REPLICA_METRIC_COUNT; m++) {
+        char name[48];
+        replicaMetricName(m, name, sizeof(name));
+        // Welford's running mean and sum of squared deviations; the naive
+        // sum of squares cancels badly when the spread is small.
+        int n = 0;
+        double mean = 0, squares = 0, value;
+        for (int i = 0; i < count; i++) {
+            if (!results[i].completed || !replicaMetricValue(&results[i], m, &value)) continue;
+            n++;
+            double delta = value - mean;
+            mean += delta / n;
+            squares += delta * (value - mean);
+        }
+        double variance = n > 1 ? squares / (n - 1) : 0;
+        double sd = variance > 0 ? sqrt(variance) : 0;
+        double half = n > 1 ? tQuantile95(n - 1) * sd / sqrt(n) : 0;
+        if (json) {
+            fprintf(out, "%s\n    \"%s\": {\"n\": %d, \"mean\": %.4f, \"sd\": %.4f, \"ci95\": [%.4f, %.4f]}",
+                    m == 0 ? "" : ",", name, n, mean, sd, mean - half, mean + half);
+        } else {
+            printf("%-26s %5d %10.3f %10.3f %10.3f %10.3f\n", name, n, mean, sd,
+                   mean - half, mean + half);
+        }
+    }
+    if (json) {
+        fprintf(out, "\n  },\n  \"runs\": [");
+        bool first = true;
+        for (int i = 0; i < count; i++) {
+            const ReplicaResult* r = &results[i];
+            if (!r->completed) continue;
+            fprintf(out, "%s\n    {\"seed\": %llu, \"movements\": %d, \"hours\": %.5f, \"mean_wait_s\": %.3f, "
+                    "\"p90_wait_s\": %.3f, \"emergency_latency_s\": %.3f, \"avn_per_movement\": %.4f}",
+                    first ? "" : ",", (unsigned long long)r->seed, r->movements, r->hours, r->meanWait,
+                    r->p90Wait, r->emergencyLatency, r->violationRate);
+            first = false;
+        }
+        fprintf(out, "\n  ]\n}\n");
+    }
+}
+
+// Runs replicaCount replicas of the scenario and prints confidence intervals;
+// with outPath the full report is also written there as JSON.
+int runReplicas(const char* scenarioPath, const char* trafficSpec, Airline airlines[], Flight* flights,
+                const char* outPath) {
+    ReplicaResult* results = calloc(replicaCount, sizeof(ReplicaResult));
+    pid_t* pids = malloc(sizeof(pid_t) * replicaCount);
+    int* fds = malloc(sizeof(int) * replicaCount);
+    if (!results || !pids || !fds) {
+        perror("Failed to allocate replicas");
+        free(results);
+        free(pids);
+        free(fds);
+        return 1;
+    }
+    int jobs = replicaJobs > 0 ? replicaJobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1) jobs = 1;
+    uint64_t start = monotonicNs();
+    int launched = 0, running = 0, finished = 0;
+    fflush(stdout);
+    while (finished < replicaCount) {
+        while (launched < replicaCount && running < jobs) {
+            int r = launched++;
+            uint64_t state = scenarioSeed + (uint64_t)r;
+            uint64_t seed = splitmix64(&state);
+            pids[r] = -1;
+            fds[r] = -1;
+            int p[2];
+            if (pipe(p) < 0) {
+                perror("Failed to create replica pipe");
+                finished++;
+                continue;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(p[0]);
+                runReplica(seed, scenarioPath, trafficSpec, airlines, flights, p[1]);
+            }
+            close(p[1]);
+            if (pid < 0) {
+                perror("Failed to fork replica");
+                close(p[0]);
+                finished++;
+                continue;
+            }
+            pids[r] = pid;
+            fds[r] = p[0];
+            running++;
+        }
+        if (running == 0) continue;
+        pid_t done = waitpid(-1, NULL, 0);
+        if (done < 0) break;
+        for (int r = 0; r < launched; r++) {
+            if (pids[r] != done) continue;
+            if (read(fds[r], &results[r], sizeof(ReplicaResult)) != sizeof(ReplicaResult)) results[r].completed = false;
+            close(fds[r]);
+            pids[r] = -1;
+            running--;
+            finished++;
+            if (finished % 50 == 0 || finished == replicaCount) {
+                printf("\r%d/%d replicas", finished, replicaCount);
+                fflush(stdout);
+            }
+            break;
+        }
+    }
+    double elapsedMs = (monotonicNs() - start) / 1e6;
+    reportReplicas(stdout, results, replicaCount, elapsedMs, false);
+    if (outPath) {
+        FILE* out = fopen(outPath, "w");
+        if (out) {
+            reportReplicas(out, results, replicaCount, elapsedMs, true);
+            fclose(out);
+        } else {
+            perror("Failed to open replica report");
+        }
+    }
+    free(results);
+    free(pids);
+    free(fds);
+    return 0;
+}
+
+// Distributed runs (--pdes). Each q1 process is one airport: a logical
+// process with its own flights, runways and virtual clock. A departure that
+// finishes at one airport arrives at another transit seconds later, carried
+// as a handoff over a SOCK_SEQPACKET socket between the two processes.
+// Synchronisation is conservative (Chandy-Misra-Bryant): a node only runs
+// events earlier than every peer's promised clock, and promises its own with
+// null messages. The transit time is the lookahead. Handoffs are admitted in
+// (time, sender, sequence) order before any local event at or after their
+// time, so each node's run is the same on every execution.
+#define MAX_PDES_NODES 16
+#define PDES_CONNECT_TIMEOUT_MS 10000
+
+typedef enum { PDES_HELLO, PDES_NULL, PDES_HANDOFF, PDES_DONE } PdesMessageType;
+
+typedef struct {
+    uint8_t type;
+    uint8_t from;
+    uint16_t airlineCount;
+    uint32_t seq;
+    double time;          // handoff: arrival time; null: no later handoff will be earlier
+    ScenarioMovement movement;
+    char flightId[20];    // handoff: the flight keeps its id and random stream
+    RngStream rng;
+} PdesMessage;
+
+typedef struct {
+    int in;               // connection the peer sends on
+    int out;              // connection we send on
+    double clock;         // the peer's promise to us
+    double promised;      // our last promise to the peer
+    bool done;
+} PdesPeer;
+
+int pdesNode = -1;        // -1 with pdesNodes set: fork every node locally
+int pdesNodes = 0;
+double pdesTransit = 60.0;
+char* pdesDir = NULL;
+PdesPeer pdesPeers[MAX_PDES_NODES];
+PdesMessage* pdesPending = NULL;   // received handoffs not yet admitted, in order
+int pdesPendingCount = 0;
+int pdesPendingCapacity = 0;
+uint32_t pdesSequence = 0;
+int pdesDeparturesLeft = 0;
+int pdesHandoffsOut = 0;
+int pdesHandoffsIn = 0;
+int pdesNullsOut = 0;
+uint64_t pdesDigest = FNV_OFFSET_BASIS;
+
+bool parsePdesSpec(const char* spec) {
+    char buffer[256];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        if (!eq) return false;
+        *eq = '\0';
+        const char* value = eq + 1;
+        if (strcmp(item, "node") == 0) pdesNode = atoi(value);
+        else if (strcmp(item, "nodes") == 0) pdesNodes = atoi(value);
+        else if (strcmp(item, "transit") == 0) pdesTransit = atof(value);
+        else if (strcmp(item, "dir") == 0) {
+            free(pdesDir);
+            pdesDir = strdup(value);
+        }
+        else return false;
+    }
+    return pdesNodes >= 2 && pdesNodes <= MAX_PDES_NODES && pdesNode < pdesNodes && pdesTransit > 0;
+}
+
+void pdesSocketAddress(int node, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/pdes-%d.sock", pdesDir ? pdesDir : ".", node);
+}
+
+bool pdesSend(int to, PdesMessage* m) {
+    m->from = (uint8_t)pdesNode;
+    m->airlineCount = (uint16_t)airlineCount;
+    m->seq = pdesSequence++;
+    if (send(pdesPeers[to].out, m, sizeof(*m), MSG_NOSIGNAL) != (ssize_t)sizeof(*m)) {
+        fprintf(stderr, "PDES node %d: failed to send to node %d: %s\n", pdesNode, to, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Listens for the other nodes, connects to each of them and waits until
+// every peer has said hello on its own connection.
+bool pdesConnect() {
+    struct sockaddr_un addr;
+    pdesSocketAddress(pdesNode, &addr);
+    int listenFd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    unlink(addr.sun_path);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, MAX_PDES_NODES) < 0) {
+        perror("Failed to listen for PDES peers");
+        if (listenFd >= 0) close(listenFd);
+        return false;
+    }
+    for (int j = 0; j < pdesNodes; j++) pdesPeers[j] = (PdesPeer){ -1, -1, 0, 0, false };
+
+    uint64_t deadline = monotonicNs() + PDES_CONNECT_TIMEOUT_MS * 1000000ULL;
+    bool ok = true;
+    for (int j = 0; j < pdesNodes && ok; j++) {
+        if (j == pdesNode) continue;
+        struct sockaddr_un peer;
+        pdesSocketAddress(j, &peer);
+        while (pdesPeers[j].out < 0) {
+            int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+            if (fd >= 0 && connect(fd, (struct sockaddr*)&peer, sizeof(peer)) == 0) {
+                pdesPeers[j].out = fd;
+                break;
+            }
+            if (fd >= 0) close(fd);
+            if (monotonicNs() > deadline) {
+                fprintf(stderr, "PDES node %d: node %d did not come up at %s\n", pdesNode, j, peer.sun_path);
+                ok = false;
+                break;
+            }
+            usleep(20000);
+        }
+        PdesMessage hello = { .type = PDES_HELLO };
+        if (ok && !pdesSend(j, &hello)) ok = false;
+    }
+    for (int accepted = 0; ok && accepted < pdesNodes - 1; accepted++) {
+        struct pollfd p = { .fd = listenFd, .events = POLLIN };
+        int remaining = (int)(((int64_t)deadline - (int64_t)monotonicNs()) / 1000000);
+        if (remaining < 0 || poll(&p, 1, remaining) <= 0) {
+            fprintf(stderr, "PDES node %d: timed out waiting for peers\n", pdesNode);
+            ok = false;
+            break;
+        }
+        int fd = accept(listenFd, NULL, NULL);
+        PdesMessage hello;
+        if (fd < 0 || recv(fd, &hello, sizeof(hello), 0) != (ssize_t)sizeof(hello) || hello.type != PDES_HELLO ||
+            hello.from >= pdesNodes || hello.from == pdesNode || pdesPeers[hello.from].in >= 0) {
+            fprintf(stderr, "PDES node %d: bad hello from a peer\n", pdesNode);
+            if (fd >= 0) close(fd);
+            ok = false;
+            break;
+        }
+        if (hello.airlineCount != airlineCount) {
+            fprintf(stderr, "PDES node %d: node %d has %d airlines, this node has %d\n", pdesNode, hello.from,
+                    hello.airlineCount, airlineCount);
+            close(fd);
+            ok = false;
+            break;
+        }
+        pdesPeers[hello.from].in = fd;
+    }
+    close(listenFd);
+    unlink(addr.sun_path);
+    return ok;
+}
+
+void pdesDisconnect() {
+    for (int j = 0; j < pdesNodes; j++) {
+        if (pdesPeers[j].in >= 0) close(pdesPeers[j].in);
+        if (pdesPeers[j].out >= 0) close(pdesPeers[j].out);
+        pdesPeers[j].in = pdesPeers[j].out = -1;
+    }
+    free(pdesPending);
+    pdesPending = NULL;
+    pdesPendingCount = pdesPendingCapacity = 0;
+}
+
+bool pdesMessageBefore(const PdesMessage* a, const PdesMessage* b) {
+    if (a->time != b->time) return a->time < b->time;
+    if (a->from != b->from) return a->from < b->from;
+    return a->seq < b->seq;
+}
+
+bool pdesQueueHandoff(const PdesMessage* m) {
+    if (pdesPendingCount == pdesPendingCapacity) {
+        int capacity = pdesPendingCapacity ? pdesPendingCapacity * 2 : 64;
+        PdesMessage* grown = realloc(pdesPending, sizeof(PdesMessage) * capacity);
+        if (!grown) {
+            perror("Failed to queue PDES handoff");
+            return false;
+        }
+        pdesPending = grown;
+        pdesPendingCapacity = capacity;
+    }
+    int i = pdesPendingCount++;
+    while (i > 0 && pdesMessageBefore(m, &pdesPending[i - 1])) {
+        pdesPending[i] = pdesPending[i - 1];
+        i--;
+    }
+    pdesPending[i] = *m;
+    return true;
+}
+
+// Reads whatever the peers have sent; with block it first waits for at least
+// one message. A peer that hangs up before saying it is done fails the run.
+bool pdesReceive(bool block) {
+    struct pollfd fds[MAX_PDES_NODES];
+    int owners[MAX_PDES_NODES];
+    int n = 0;
+    for (int j = 0; j < pdesNodes; j++) {
+        if (pdesPeers[j].in < 0) continue;
+        fds[n] = (struct pollfd){ .fd = pdesPeers[j].in, .events = POLLIN };
+        owners[n++] = j;
+    }
+    if (n == 0) return true;
+    if (poll(fds, n, block ? -1 : 0) < 0 && errno != EINTR) {
+        perror("PDES poll failed");
+        return false;
+    }
+    for (int k = 0; k < n; k++) {
+        if (!fds[k].revents) continue;
+        PdesPeer* peer = &pdesPeers[owners[k]];
+        while (peer->in >= 0) {
+            PdesMessage m;
+            ssize_t got = recv(peer->in, &m, sizeof(m), MSG_DONTWAIT);
+            if (got < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+                perror("PDES receive failed");
+                return false;
+            }
+            if (got == 0) {
+                close(peer->in);
+                peer->in = -1;
+                if (!peer->done) {
+                    fprintf(stderr, "PDES node %d: node %d hung up early\n", pdesNode, owners[k]);
+                    return false;
+                }
+                break;
+            }
+            if (got != (ssize_t)sizeof(m)) continue;
+            if (m.type == PDES_DONE) {
+                peer->done = true;
+                peer->clock = INFINITY;
+                continue;
+            }
+            if (m.time > peer->clock) peer->clock = m.time;
+            if (m.type == PDES_HANDOFF && !pdesQueueHandoff(&m)) return false;
+        }
+    }
+    return true;
+}
+
+double pdesSafeTime() {
+    double safe = INFINITY;
+    for (int j = 0; j < pdesNodes; j++) {
+        if (j != pdesNode && pdesPeers[j].clock < safe) safe = pdesPeers[j].clock;
+    }
+    return safe;
 }
 
+// Tells each peer no handoff from us will be earlier than bound. Outside of
+// force a null goes out only once the promise has moved by half the
+// lookahead; before blocking every peer gets the current bound, which is what
+// keeps the nodes from waiting on each other forever.
+bool pdesPromise(double bound, bool force) {
+    for (int j = 0; j < pdesNodes; j++) {
+        PdesPeer* peer = &pdesPeers[j];
+        if (j == pdesNode || bound <= peer->promised) continue;
+        if (!force && bound != INFINITY && bound - peer->promised < pdesTransit / 2) continue;
+        PdesMessage m = { .type = bound == INFINITY ? PDES_DONE : PDES_NULL, .time = bound };
+        if (!pdesSend(j, &m)) return false;
+        peer->promised = bound;
+        pdesNullsOut++;
+    }
+    return true;
+}
+
+// A finished departure leaves for one of the other airports, picked from its
+// own random stream.
+bool pdesHandoff(Flight* f, double now) {
+    int pick = rngBelow(&f->rng, pdesNodes - 1);
+    int to = pick >= pdesNode ? pick + 1 : pick;
+    PdesMessage m = { .type = PDES_HANDOFF, .time = now + pdesTransit };
+    m.movement = (ScenarioMovement){ 0, (uint8_t)f->airlineId, 0, f->isVIP, 0, (int16_t)f->fuelLevel,
+                                     SCENARIO_RANDOM, 0 };
+    memcpy(m.flightId, f->id, sizeof(m.flightId));
+    m.rng = f->rng;
+    if (!pdesSend(to, &m)) return false;
+    if (m.time > pdesPeers[to].promised) pdesPeers[to].promised = m.time;
+    pdesHandoffsOut++;
+    return true;
+}
+
+bool pdesAdmit(Flight* flights, int* flightCount, FlightLifecycle* spare, int spareCount, LifecycleScheduler* s) {
+    PdesMessage m = pdesPending[0];
+    memmove(pdesPending, pdesPending + 1, sizeof(PdesMessage) * --pdesPendingCount);
+    if (m.time < virtualNow) {
+        fprintf(stderr, "PDES node %d: handoff %s from node %d at %.3f s is behind the clock (%.3f s)\n",
+                pdesNode, m.flightId, m.from, m.time, virtualNow);
+    }
+    lockFlightData();
+    m.flightId[sizeof(m.flightId) - 1] = '\0';
+    bool added = pdesHandoffsIn < spareCount &&
+                 addScenarioFlight(airlineRegistry, flights, flightCount, &m.movement, m.flightId);
+    if (added) flights[*flightCount - 1].rng = m.rng;
+    unlockFlightData();
+    if (!added) {
+        fprintf(stderr, "PDES node %d: no room for handoff %s\n", pdesNode, m.flightId);
+        return false;
+    }
+    scheduleFlightLifecycle(&spare[pdesHandoffsIn++], &flights[*flightCount - 1], INT_MAX, m.time, s);
+    return true;
+}
+
+// The node's event loop, on the single virtual-clock scheduler.
+bool pdesRun(LifecycleScheduler* s, Flight* flights, int* flightCount, FlightLifecycle* spare, int spareCount) {
+    while (1) {
+        if (!pdesReceive(false)) return false;
+        double safe = pdesSafeTime();
+        double local = s->heapCount > 0 ? s->heap[0]->wakeTime : INFINITY;
+        double remote = pdesPendingCount > 0 ? pdesPending[0].time : INFINITY;
+        double next = local < remote ? local : remote;
+        double bound = pdesDeparturesLeft > 0 ? (next < safe ? next : safe) + pdesTransit : INFINITY;
+        if (next >= safe) {
+            if (!pdesPromise(bound, true)) return false;
+            if (next == INFINITY && safe == INFINITY) return true;
+            if (!pdesReceive(true)) return false;
+            continue;
+        }
+        if (!pdesPromise(bound, false)) return false;
+        if (remote <= local) {
+            if (!pdesAdmit(flights, flightCount, spare, spareCount, s)) return false;
+            continue;
+        }
+        pthread_mutex_lock(&s->lock);
+        FlightLifecycle* lc = heapPop(s);
+        pthread_mutex_unlock(&s->lock);
+        if (lc->wakeTime > virtualNow) virtualNow = lc->wakeTime;
+        double now = virtualNow;
+        double wake = resumeFlightLifecycle(lc, now);
+        int32_t index = (int32_t)(lc->flight - flights);
+        pdesDigest = fnvHash(pdesDigest, &index, sizeof(index));
+        pdesDigest = fnvHash(pdesDigest, &now, sizeof(now));
+        if (wake == LIFECYCLE_DONE) {
+            s->pending--;
+            if (lc->plan == departurePlan) {
+                pdesDeparturesLeft--;
+                if (!pdesHandoff(lc->flight, now)) return false;
+            }
+        } else if (wake != LIFECYCLE_PARKED) {
+            pthread_mutex_lock(&s->lock);
+            lc->wakeTime = wake;
+            heapPush(s, lc);
+            pthread_mutex_unlock(&s->lock);
+        }
+    }
+}
+
+// Runs this process as node pdesNode. Each node draws its own traffic from
+// the base seed, the same way replicas do.
+int runPdesNode(const char* scenarioPath, const char* trafficSpec, Flight* flights) {
+    uint64_t state = scenarioSeed + (uint64_t)pdesNode;
+    scenarioSeed = splitmix64(&state);
+    headless = true;
+    rngSeed(&controlRng, scenarioSeed, 0);
+    virtualClock = true;
+    virtualNow = 0;
+    int flightCount = 0;
+    if (scenarioPath && loadScenarioFile(scenarioPath, airlineRegistry, flights, &flightCount) < 0) return 1;
+    if (trafficSpec && loadGeneratedTraffic(trafficSpec, NULL, airlineRegistry, flights, &flightCount) < 0) return 1;
+    if (!pdesConnect()) {
+        pdesDisconnect();
+        return 1;
+    }
+    uint64_t start = monotonicNs();
+    planQueues(flights, flightCount);
+    pdesDeparturesLeft = 0;
+    for (int i = 0; i < flightCount; i++) pdesDeparturesLeft += flights[i].isDeparture;
+    int scheduled = flightCount;
+    FlightLifecycle* lifecycles = prepareFlightLifecycles(flights, NULL, 0, MAX_FLIGHTS - flightCount);
+    if (!lifecycles) {
+        pdesDisconnect();
+        return 1;
+    }
+    simulationRunning = true;
+    bool ok = pdesRun(&schedulers[0], flights, &flightCount, lifecycles + scheduled, MAX_FLIGHTS - scheduled);
+    simulationRunning = false;
+    releaseFlightLifecycles(lifecycles);
+    pdesDisconnect();
+    if (!ok) return 1;
+    double meanWait = runOutcome.movements > 0 ? runOutcome.totalWait / runOutcome.movements : 0;
+    printf("PDES node %d/%d: %d movements (%d local, %d handed in), %d handed out, %d null messages, "
+           "finished at %.1f s, mean wait %.3f s, %.0f ms, digest %016llx\n",
+           pdesNode, pdesNodes, runOutcome.movements, scheduled, pdesHandoffsIn, pdesHandoffsOut, pdesNullsOut,
+           runOutcome.finishedAt, meanWait, (monotonicNs() - start) / 1e6, (unsigned long long)pdesDigest);
+    fflush(stdout);
+    clearFlights(flights, flightCount);
+    return 0;
+}
+
+// Without node= every node is forked here, so a whole region can be tried on
+// one machine; with it this process is one node and the others are started
+// separately, by hand or on other shells.
+int runPdes(const char* scenarioPath, const char* trafficSpec, Flight* flights) {
+    if (pdesNode >= 0) return runPdesNode(scenarioPath, trafficSpec, flights);
+    pid_t pids[MAX_PDES_NODES];
+    fflush(stdout);
+    for (int n = 0; n < pdesNodes; n++) {
+        pids[n] = fork();
+        if (pids[n] == 0) {
+            pdesNode = n;
+            lookaheadForkDirect = true;
+            logLevel = LOG_OFF;
+            traceFile = NULL;
+            _exit(runPdesNode(scenarioPath, trafficSpec, flights));
+        }
+        if (pids[n] < 0) perror("Failed to fork PDES node");
+    }
+    int failed = 0;
+    for (int n = 0; n < pdesNodes; n++) {
+        int status = 0;
+        if (pids[n] < 0 || waitpid(pids[n], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed++;
+        }
+    }
+    if (failed) fprintf(stderr, "%d of %d PDES nodes failed\n", failed, pdesNodes);
+    return failed ? 1 : 0;
+}
+
+// The display runs at renderFps (--fps) while anything on screen is moving
+// and drops to RENDER_IDLE_FPS once nothing has been published for
+// RENDER_IDLE_AFTER seconds, which is still often enough to answer window
+// events and keep the title current.
+#define DEFAULT_RENDER_FPS 60
+#define MAX_RENDER_FPS 240
+#define RENDER_IDLE_FPS 4
+#define RENDER_IDLE_AFTER 1.0
+
 sfRenderWindow* window = NULL;
 bool sfmlRunning = false;
+int renderFps = DEFAULT_RENDER_FPS;
+
+// Sleeps until *deadline, then moves it on by period; a frame that overran
+// by more than a period starts a fresh schedule rather than rushing to
+// catch up.
+void waitForFrame(uint64_t* deadline, uint64_t period) {
+    uint64_t now = monotonicNs();
+    if (now < *deadline) {
+        struct timespec until = { (time_t)(*deadline / 1000000000ULL), (long)(*deadline % 1000000000ULL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+        }
+        *deadline += period;
+    } else if (now - *deadline > period) {
+        *deadline = now + period;
+    } else {
+        *deadline += period;
+    }
+}
 
 void* sfmlThread(void* arg) {
     ThreadData* data = (ThreadData*)arg;
@@ -1113,43 +6245,225 @@ void* sfmlThread(void* arg) {
     }
     sfSprite* backgroundSprite = sfSprite_create();
     sfSprite_setTexture(backgroundSprite, backgroundTexture, sfTrue);
-    sfClock* clock = sfClock_create();
+    uint64_t titleGeneration = 0;
+    uint64_t activePeriod = 1000000000ULL / renderFps;
+    uint64_t idlePeriod = 1000000000ULL / RENDER_IDLE_FPS;
+    uint64_t deadline = monotonicNs();
+    bool active = true;
     sfmlRunning = true;
     while (sfmlRunning) {
+        waitForFrame(&deadline, active ? activePeriod : idlePeriod);
+        uint64_t frameStart = monotonicNs();
         sfEvent event;
         while (sfRenderWindow_pollEvent(window, &event)) {
             if (event.type == sfEvtClosed) {
                 sfmlRunning = false;
             }
         }
-        float deltaTime = sfTime_asSeconds(sfClock_restart(clock));
         sfRenderWindow_clear(window, sfBlack);
         sfRenderWindow_drawSprite(window, backgroundSprite, NULL);
-        pthread_mutex_lock(&flightDataMutex);
+        double now = monotonicSeconds();
+        active = false;
+        lockFlightData();
         for (int i = 0; i < data->flightCount; i++) {
             Flight* f = &data->flights[i];
-            if (f->sprite) {
-                updateFlightPosition(f, deltaTime);
-                sfRenderWindow_drawSprite(window, f->sprite, NULL);
-            }
+            if (!f->sprite) continue;
+            const RenderSample* sample = renderSampleOf(f);
+            if (sample && sample->published && now - sample->toTime < RENDER_IDLE_AFTER) active = true;
+            sfSprite_setPosition(f->sprite, displayedFlightPosition(f, now));
+            sfRenderWindow_drawSprite(window, f->sprite, NULL);
+        }
+        unlockFlightData();
+        // The title carries the live violation counts; it is only rebuilt
+        // when the index has changed since the last frame.
+        char title[128];
+        bool retitle = false;
+        pthread_mutex_lock(&violationIndexLock);
+        if (violationIndex.generation != titleGeneration) {
+            const int* kinds = violationIndex.kindCounts;
+            snprintf(title, sizeof(title), "ATCS CONTROLLER SYSTEM | AVN flights %d | speed %d pos %d alt %d rwy %d",
+                     violationIndex.activeCount, kinds[0], kinds[1], kinds[2], kinds[3]);
+            titleGeneration = violationIndex.generation;
+            retitle = true;
         }
-        pthread_mutex_unlock(&flightDataMutex);
+        pthread_mutex_unlock(&violationIndexLock);
+        if (retitle) sfRenderWindow_setTitle(window, title);
         sfRenderWindow_display(window);
+        recordLatency(METRIC_RENDER_FRAME, monotonicNs() - frameStart);
+        countEvent(COUNTER_FRAMES);
     }
     sfSprite_destroy(backgroundSprite);
     sfTexture_destroy(backgroundTexture);
-    sfClock_destroy(clock);
     sfRenderWindow_destroy(window);
     return NULL;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     pid_t reader_pid = 0;
-    srand(time(NULL));
+    bool benchMode = false;
+    const char* benchOutPath = NULL;
+    const char* scenarioPath = NULL;
+    const char* trafficSpec = NULL;
+    const char* scenarioOutPath = NULL;
+    bool runImmediately = false;
+    const char* replayPath = NULL;
+    bool replayRender = false;
+    const char* snapshotPath = NULL;
+    const char* restorePath = NULL;
+    const char* replicaOutPath = NULL;
+    const char* runwayConfigPath = NULL;
+    const char* airlineRegistryPath = NULL;
+    const char* radarSource = NULL;
+    scenarioSeed = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            scenarioSeed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            benchMode = true;
+            headless = true;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            trafficSpec = argv[++i];
+        } else if (strcmp(argv[i], "--scenario-out") == 0 && i + 1 < argc) {
+            scenarioOutPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            if (!openTrace(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--render") == 0) {
+            replayRender = true;
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot-interval") == 0 && i + 1 < argc) {
+            snapshotIntervalMs = atoi(argv[++i]);
+            if (snapshotIntervalMs < 10) snapshotIntervalMs = 10;
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            restorePath = argv[++i];
+        } else if (strcmp(argv[i], "--lookahead") == 0 && i + 1 < argc) {
+            lookaheadCandidates = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replicas") == 0 && i + 1 < argc) {
+            replicaCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replica-jobs") == 0 && i + 1 < argc) {
+            replicaJobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replica-out") == 0 && i + 1 < argc) {
+            replicaOutPath = argv[++i];
+        } else if (strcmp(argv[i], "--runways") == 0 && i + 1 < argc) {
+            runwayConfigPath = argv[++i];
+        } else if (strcmp(argv[i], "--airlines") == 0 && i + 1 < argc) {
+            airlineRegistryPath = argv[++i];
+        } else if (strcmp(argv[i], "--probe") == 0 && i + 1 < argc) {
+            if (!parseProbeSpec(argv[++i])) {
+                fprintf(stderr, "Invalid probe spec; expected horizon=S[,separation=PX][,vertical=FT]\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--radar") == 0 && i + 1 < argc) {
+            radarSource = argv[++i];
+        } else if (strcmp(argv[i], "--radar-gate") == 0 && i + 1 < argc) {
+            radarGate = strtof(argv[++i], NULL);
+            if (!(radarGate > 0)) {
+                fprintf(stderr, "--radar-gate must be a positive distance\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--pdes") == 0 && i + 1 < argc) {
+            if (!parsePdesSpec(argv[++i])) {
+                fprintf(stderr, "Invalid PDES spec: %s (nodes=2-%d[,node=I][,transit=S][,dir=PATH])\n",
+                        argv[i], MAX_PDES_NODES);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sectors") == 0 && i + 1 < argc) {
+            sectorCount = atoi(argv[++i]);
+            if (sectorCount < 1 || sectorCount > MAX_SECTORS) {
+                fprintf(stderr, "Invalid sector count: %s (1-%d)\n", argv[i], MAX_SECTORS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--ground") == 0 && i + 1 < argc) {
+            if (!parseGroundSpec(argv[++i])) {
+                fprintf(stderr, "Invalid ground spec: %s (gates and taxiways 1-%d)\n", argv[i], MAX_GROUND_RESOURCES);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--avn-socket") == 0 && i + 1 < argc) {
+            avnSocketPath = argv[++i];
+        } else if (strcmp(argv[i], "--sp-socket") == 0 && i + 1 < argc) {
+            spSocketPath = argv[++i];
+        } else if (strcmp(argv[i], "--sector") == 0 && i + 1 < argc) {
+            sectorName = argv[++i];
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            renderFps = atoi(argv[++i]);
+            if (renderFps < 1 || renderFps > MAX_RENDER_FPS) {
+                fprintf(stderr, "Invalid frame rate: %s (1-%d)\n", argv[i], MAX_RENDER_FPS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--run") == 0) {
+            runImmediately = true;
+        } else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+            benchOutPath = argv[++i];
+        } else if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            statsFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            const char* sink = argv[++i];
+            if (strcmp(sink, "console") == 0) logSink = LOG_SINK_CONSOLE;
+            else if (strcmp(sink, "file") == 0) logSink = LOG_SINK_FILE;
+            else if (strcmp(sink, "binary") == 0) logSink = LOG_SINK_BINARY;
+            else {
+                fprintf(stderr, "Invalid log sink: %s (console, file or binary)\n", sink);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            const char* level = argv[++i];
+            if (strcmp(level, "trace") == 0) logLevel = LOG_TRACE;
+            else if (strcmp(level, "debug") == 0) logLevel = LOG_DEBUG;
+            else if (strcmp(level, "info") == 0) logLevel = LOG_INFO;
+            else if (strcmp(level, "warn") == 0) logLevel = LOG_WARN;
+            else if (strcmp(level, "error") == 0) logLevel = LOG_ERROR;
+            else if (strcmp(level, "off") == 0) logLevel = LOG_OFF;
+            else {
+                fprintf(stderr, "Invalid log level: %s (trace, debug, info, warn, error or off)\n", level);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--seed N] [--log console|file|binary] "
+                    "[--log-level trace|debug|info|warn|error|off] [--stats-file PATH] "
+                    "[--bench [--bench-out PATH]] [--headless] [--fps N] [--scenario PATH] "
+                    "[--generate SPEC [--scenario-out PATH]] [--run] [--record PATH] "
+                    "[--replay PATH [--render]] [--snapshot PATH [--snapshot-interval MS]] "
+                    "[--restore PATH] [--lookahead N] "
+                    "[--replicas N [--replica-jobs J] [--replica-out PATH]] [--runways PATH] "
+                    "[--airlines PATH] [--ground gates=N,taxiways=N,turnaround=S] "
+                    "[--avn-socket PATH [--sector NAME]] [--sp-socket PATH] [--sectors N] "
+                    "[--pdes nodes=N[,node=I][,transit=S][,dir=PATH]] [--radar PATH|unix:PATH] [--radar-gate D] "
+                    "[--probe horizon=S[,separation=PX][,vertical=FT]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (runwayConfigPath) {
+        if (!loadRunwayConfig(runwayConfigPath)) return 1;
+    } else {
+        loadDefaultRunways();
+    }
+    if (airlineRegistryPath) {
+        if (!loadAirlineRegistry(airlineRegistryPath)) return 1;
+    } else {
+        loadDefaultAirlines();
+    }
+    if (restorePath && (scenarioPath || trafficSpec || replayPath)) {
+        fprintf(stderr, "--restore cannot be combined with --scenario, --generate or --replay\n");
+        return 1;
+    }
+    // A trace starts with the store a run was planned from; restored and
+    // radar-fed flights never go through that start.
+    if (traceFile && (restorePath || radarSource)) {
+        fprintf(stderr, "--record cannot be combined with --restore or --radar\n");
+        return 1;
+    }
+    if (replayPath) headless = !replayRender;
+    if (!benchMode && !restorePath) printf("Scenario seed: %llu\n", (unsigned long long)scenarioSeed);
+    rngSeed(&controlRng, scenarioSeed, 0);
     simulationStartTime = time(NULL);
     pthread_mutex_init(&flightDataMutex, NULL);
-    loadTextures();
-    flightDataReady = true;
+    schedulerInit();
     pthread_mutexattr_t attr;
     pthread_mutexattr_init(&attr);
     pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
@@ -1157,27 +6471,136 @@ int main() {
         pthread_mutex_init(&runwayLocks[i], &attr);
     }
     pthread_mutexattr_destroy(&attr);
-    Airline airlines[MAX_AIRLINES] = {
-        {"PIA", COMMERCIAL, 6, 4, 0},
-        {"AirBlue", COMMERCIAL, 4, 4, 0},
-        {"FedEx", CARGO, 3, 2, 0},
-        {"Pakistan Airforce", EMERGENCY, 2, 1, 0},
-        {"Blue Dart", CARGO, 2, 2, 0},
-        {"AghaKhan Air", EMERGENCY, 2, 1, 0}
-    };
-    Flight flights[MAX_FLIGHTS];
+    Airline* airlines = airlineRegistry;
+    Flight* flights = NULL;
+    if (!benchMode) {
+        flights = calloc(MAX_FLIGHTS, sizeof(Flight));
+        if (!flights) {
+            perror("Failed to allocate flight store");
+            return 1;
+        }
+        if (!violationIndexInit(flights)) return 1;
+        if (probe.enabled && !conflictProbeInit(flights)) return 1;
+    }
+    if (!benchMode && pdesNodes > 0) {
+        int rc = 1;
+        // A single node runs in this process; forking every node locally
+        // needs a process with no threads yet.
+        if (pdesNode >= 0) {
+            if (lookaheadCandidates > 1) lookaheadInit(flights);
+            logInit();
+            statsInit();
+        }
+        if (restorePath || replayPath || replicaCount > 0) fprintf(stderr, "--pdes cannot be combined with --restore, --replay or --replicas\n");
+        else if (scenarioPath || trafficSpec) rc = runPdes(scenarioPath, trafficSpec, flights);
+        else fprintf(stderr, "--pdes needs --scenario or --generate\n");
+        lookaheadShutdown();
+        free(flights);
+        schedulerDestroy();
+        statsShutdown();
+        logShutdown();
+        return rc;
+    }
+    // Replicas fork here, before the log sink, stats writer or any other
+    // thread exists, so no child inherits a lock held by a thread it lacks.
+    if (!benchMode && replicaCount > 0) {
+        int rc = 1;
+        if (scenarioPath || trafficSpec) rc = runReplicas(scenarioPath, trafficSpec, airlines, flights, replicaOutPath);
+        else fprintf(stderr, "--replicas needs --scenario or --generate\n");
+        free(flights);
+        schedulerDestroy();
+        return rc;
+    }
+    // The lookahead helper forks its candidates, so it too must be forked
+    // before any thread starts.
+    if (!benchMode && !radarSource && !replayPath && lookaheadCandidates > 1) lookaheadInit(flights);
+    logInit();
+    statsInit();
+    if (!headless) loadTextures();
+    flightDataReady = true;
+    if (benchMode) {
+        int rc = runBenchmarks(airlines, benchOutPath);
+        schedulerDestroy();
+        statsShutdown();
+        logShutdown();
+        return rc;
+    }
+    if (!headless && !renderTrackInit(flights)) return 1;
     int flightCount = 0;
     char flightIdBuffer[20];
-    pthread_t sfmlThreadId;
+    SnapshotLifecycle* restoredLifecycles = NULL;
+    int restoredLifecycleCount = 0;
+    if (restorePath) {
+        restoredLifecycleCount = restoreSnapshot(restorePath, airlines, flights, &flightCount, &restoredLifecycles);
+        if (restoredLifecycleCount < 0) return 1;
+    }
+    if (scenarioPath && loadScenarioFile(scenarioPath, airlines, flights, &flightCount) < 0) return 1;
+    if (trafficSpec && loadGeneratedTraffic(trafficSpec, scenarioOutPath, airlines, flights, &flightCount) < 0) return 1;
+    if (scenarioPath || trafficSpec) printf("Loaded %d scheduled movements\n", flightCount);
+    if (radarSource) {
+        int rc = runRadarIngest(radarSource, flights, flightCount);
+        clearFlights(flights, flightCount);
+        free(flights);
+        schedulerDestroy();
+        statsShutdown();
+        logShutdown();
+        return rc;
+    }
+    if (replayPath) {
+        ThreadData replayData = {flights, 0};
+        pthread_t replayRenderId;
+        if (!headless) pthread_create(&replayRenderId, NULL, sfmlThread, &replayData);
+        int rc = replayTrace(replayPath, airlines, flights, &flightCount, &replayData);
+        if (!headless) {
+            printf("Close the window to exit.\n");
+            pthread_join(replayRenderId, NULL);
+        }
+        clearFlights(flights, flightCount);
+        free(flights);
+        schedulerDestroy();
+        statsShutdown();
+        logShutdown();
+        return rc;
+    }
+    publishAirlineRegistry();
+    if (avnSocketPath && !connectAVNSocket(avnSocketPath)) return 1;
     ThreadData threadData = {flights, flightCount};
-    pthread_create(&sfmlThreadId, NULL, sfmlThread, &threadData);
+    if (snapshotPath && !snapshotInit(snapshotPath, &threadData, airlines)) return 1;
+    if (runImmediately) {
+        if (restoredLifecycleCount > 0) runSimulation(flights, flightCount, restoredLifecycles, restoredLifecycleCount);
+        else if (flightCount > 0) runSimulation(flights, flightCount, NULL, 0);
+        lockFlightData();
+        clearFlights(flights, flightCount);
+        threadData.flightCount = 0;
+        unlockFlightData();
+        snapshotShutdown();
+        lookaheadShutdown();
+        free(restoredLifecycles);
+        free(flights);
+        schedulerDestroy();
+        statsShutdown();
+        logShutdown();
+        return 0;
+    }
+    pthread_t sfmlThreadId;
+    if (!headless) pthread_create(&sfmlThreadId, NULL, sfmlThread, &threadData);
+    if (restoredLifecycleCount > 0) {
+        printf("Resuming restored simulation...\n");
+        runSimulation(flights, flightCount, restoredLifecycles, restoredLifecycleCount);
+        lockFlightData();
+        clearFlights(flights, flightCount);
+        flightCount = 0;
+        threadData.flightCount = flightCount;
+        unlockFlightData();
+    }
+    free(restoredLifecycles);
 
     while (1) {
         printf("\n=========== Airline Flight Simulator ===========\n");
         printf("Available Airlines:\n");
         printf("Index\tAirline\t\t\tType\t\tTotal\tActive\tAvailable\n");
         printf("---------------------------------------------------------------\n");
-        for (int i = 0; i < MAX_AIRLINES; i++) {
+        for (int i = 0; i < airlineCount; i++) {
             int available = airlines[i].activeFlights;
             printf("%d\t%-20s\t%-10s\t%d\t%d\t%d\n",
                    i, airlines[i].name, getFlightTypeString(airlines[i].type),
@@ -1205,9 +6628,9 @@ int main() {
                 printf("Maximum flight limit reached!\n");
                 break;
             }
-            printf("Enter airline index (0-%d): ", MAX_AIRLINES - 1);
+            printf("Enter airline index (0-%d): ", airlineCount - 1);
             int airlineChoice;
-            if (scanf("%d", &airlineChoice) != 1 || airlineChoice < 0 || airlineChoice >= MAX_AIRLINES) {
+            if (scanf("%d", &airlineChoice) != 1 || airlineChoice < 0 || airlineChoice >= airlineCount) {
                 printf("Invalid airline index!\n");
                 while (getchar() != '\n');
                 break;
@@ -1220,12 +6643,12 @@ int main() {
             airlines[airlineChoice].activeFlights--;
             bool isDeparture = (choice == 1);
             snprintf(flightIdBuffer, sizeof(flightIdBuffer), "%s%03d", isDeparture ? "DEP" : "ARR", flightCount + 1);
-            pthread_mutex_lock(&flightDataMutex);
+            lockFlightData();
             flights[flightCount] = generateFlight(airlines, airlineChoice, getCurrentSimulationTime(), flightIdBuffer, isDeparture);
             flights[flightCount].airlineId = airlineChoice;
             flights[flightCount].assignedRunway = assignRunway(&flights[flightCount]);
             initializeFlightPosition(&flights[flightCount]);
-            if (flights[flightCount].type == COMMERCIAL && rand() % 100 < 50) {
+            if (flights[flightCount].type == COMMERCIAL && rngBelow(&controlRng, 100) < 50) {
                 flights[flightCount].isVIP = true;
                 printf("Flight %s is VIP\n", flights[flightCount].id);
             }
@@ -1249,19 +6672,15 @@ int main() {
             }
             flights[flightCount].scheduledTime = scheduledTime;
             while (getchar() != '\n');
-            if (flights[flightCount].assignedRunway == RWY_A)
-                runwayAQueue[runwayACount++] = &flights[flightCount];
-            else if (flights[flightCount].assignedRunway == RWY_B)
-                runwayBQueue[runwayBCount++] = &flights[flightCount];
-            else
-                runwayCQueue[runwayCCount++] = &flights[flightCount];
+            enqueueFlight(&flights[flightCount]);
+            noteFlightChanged(&flights[flightCount]);
             if (flights[flightCount].isEmergency) {
                 QueuesReordering();
             }
             //printf("X: %f, Y: %f\n",flights[flightCount].x, flights[flightCount].y); 
             flightCount++;
             threadData.flightCount = flightCount;
-            pthread_mutex_unlock(&flightDataMutex);
+            unlockFlightData();
             printf("%s Flight %s added to %s\n",
                    isDeparture ? "Departing" : "Arriving",
                    flightIdBuffer, airlines[airlineChoice].name);
@@ -1275,7 +6694,7 @@ int main() {
             printf("\nCurrent Flights:\n");
             for (int i = 0; i < flightCount; i++) {
                 printf("%d. %s (%s) - %s | %s | Fuel: %d%% | Runway: %s\n",
-                       i + 1, flights[i].id, getAirlineName(flights[i].airlineId),
+                       i + 1, flights[i].id, airlineName(flights[i].airlineId),
                        getFlightTypeString(flights[i].type),
                        flights[i].isDeparture ? "DEPARTURE" : "ARRIVAL",
                        flights[i].fuelLevel, getRunwayString(flights[i].assignedRunway));
@@ -1288,132 +6707,92 @@ int main() {
                 printf("No flights to simulate!\n");
                 break;
             }
-            sortQueue(runwayAQueue, runwayACount);
-            sortQueue(runwayBQueue, runwayBCount);
-            sortQueue(runwayCQueue, runwayCCount);
-            QueuesReordering();
-            FindWaitTime();
-            simulationRunning = true;
-            pthread_t threads[MAX_FLIGHTS];
-            int threadIndex = 0;
-            for (int i = 0; i < runwayACount; i++) {
-                if (pthread_create(&threads[threadIndex++], NULL, Flight_ThreadScheduling, runwayAQueue[i]) != 0) {
-                    fprintf(stderr, "Failed to create thread for flight %s\n", runwayAQueue[i]->id);
-                }
-            }
-            for (int i = 0; i < runwayBCount; i++) {
-                if (pthread_create(&threads[threadIndex++], NULL, Flight_ThreadScheduling, runwayBQueue[i]) != 0) {
-                    fprintf(stderr, "Failed to create thread for flight %s\n", runwayBQueue[i]->id);
-                }
-            }
-            for (int i = 0; i < runwayCCount; i++) {
-                if (pthread_create(&threads[threadIndex++], NULL, Flight_ThreadScheduling, runwayCQueue[i]) != 0) {
-                    fprintf(stderr, "Failed to create thread for flight %s\n", runwayCQueue[i]->id);
-                }
-            }
-            for (int i = 0; i < threadIndex; i++) {
-                pthread_join(threads[i], NULL);
-            }
-            simulationRunning = false;
-            displayActiveViolations(flights, flightCount);
-            logS(flights, flightCount);
-            printf("Simulation summary logged to 'simulation_log.txt'\n");
-            pthread_mutex_lock(&flightDataMutex);
-            for (int i = 0; i < flightCount; i++) {
-                if (flights[i].sprite) {
-                    sfSprite_destroy(flights[i].sprite);
-                    flights[i].sprite = NULL;
-                }
-            }
-            memset(flights, 0, sizeof(Flight) * MAX_FLIGHTS);
+            runSimulation(flights, flightCount, NULL, 0);
+            lockFlightData();
+            clearFlights(flights, flightCount);
             flightCount = 0;
-            runwayACount = 0;
-            runwayBCount = 0;
-            runwayCCount = 0;
             threadData.flightCount = flightCount;
-            pthread_mutex_unlock(&flightDataMutex);
+            unlockFlightData();
             break;
         }
         case 5: {
             printf("Exiting simulator...\n");
             sfmlRunning = false;
-            pthread_join(sfmlThreadId, NULL);
+            if (!headless) pthread_join(sfmlThreadId, NULL);
             if (reader_pid > 0) {
                 kill(reader_pid, SIGTERM);
                 waitpid(reader_pid, NULL, 0);
             }
+            snapshotShutdown();
+            lookaheadShutdown();
             for (int i = 0; i < MAX_RUNWAYS; i++) {
                 pthread_mutex_destroy(&runwayLocks[i]);
             }
             pthread_mutex_destroy(&flightDataMutex);
+            schedulerDestroy();
+            statsShutdown();
+            logShutdown();
             return 0;
         }
         case 6: {
-            char airlineName[30];
-            char choice;
+            // Airlines are picked by registry id; the two ids after the last
+            // airline show all tickets and pay every airline at once.
+            int allTickets = airlineCount;
+            int payAll = airlineCount + 1;
+            int choice;
             printf("Enter Admin to pay tickets\n");
             printf("Select Airline:\n");
-            printf("a. PIA\n");
-            printf("b. AirBlue\n");
-            printf("c. FedEx\n");
-            printf("d. Pakistan Airforce\n");
-            printf("e. Blue Dart\n");
-            printf("f. AghaKhan Air\n");
-            printf("g. All Tickets\n");
-            printf("Enter your choice (a-g): ");
-            scanf(" %c", &choice);
-            switch (choice) {
-                case 'a': strcpy(airlineName, "PIA"); break;
-                case 'b': strcpy(airlineName, "AirBlue"); break;
-                case 'c': strcpy(airlineName, "FedEx"); break;
-                case 'd': strcpy(airlineName, "Pakistan Airforce"); break;
-                case 'e': strcpy(airlineName, "Blue Dart"); break;
-                case 'f': strcpy(airlineName, "AghaKhan Air"); break;
-                case 'g' : ;break;
-                default: printf("Invalid choice.\n"); break;
+            for (int a = 0; a < airlineCount; a++) printf("%d. %s\n", a, airlines[a].name);
+            printf("%d. All Tickets\n", allTickets);
+            printf("%d. Pay All Airlines\n", payAll);
+            printf("Enter your choice (0-%d): ", payAll);
+            if (scanf("%d", &choice) != 1 || choice < 0 || choice > payAll) {
+                printf("Invalid choice.\n");
+                while (getchar() != '\n');
+                break;
             }
-            if (choice >= 'a' && choice <= 'f') {
-                printf("Processing payment for airline: %s\n", airlineName);
-                char fifo_path2[20] = "ATCtoSP";
-                if (mkfifo(fifo_path2, 0666) < 0 && errno != EEXIST) {
-                    perror("mkfifo2 failed");
-                    exit(EXIT_FAILURE);
-                }
-                int fd2 = open(fifo_path2, O_WRONLY);
-                if (fd2 < 0) {
-                    perror("open failed");
-                    exit(EXIT_FAILURE);
-                }
-                
-                write(fd2, airlineName, sizeof(airlineName));
-                close(fd2);
+            while (getchar() != '\n');
+            if (choice < allTickets) {
+                int airlineId = choice;
+                printf("Processing payment for airline: %s\n", airlines[airlineId].name);
                 printf("\033[0;32mDo you want to pay the ticket? (Y/N): \033[0m");
                 char choice1;
                 scanf(" %c", &choice1);
                 if (choice1 == 'Y' || choice1 == 'y') {
-                    const char* fifo_path3 = "SPtoATC";
-                    if (mkfifo(fifo_path3, 0666) < 0 && errno != EEXIST) {
-                        perror("mkfifo failed");
-                        exit(EXIT_FAILURE);
-                    }
-                    int fd3 = open(fifo_path3, O_RDONLY);
-                    if (fd3 < 0) {
-                        perror("open failed");
-                        exit(EXIT_FAILURE);
-                    }
-                    int amount = 0;
-                    read(fd3, &amount, sizeof(int));
-                    if (amount > 0) {
-                        printf("\033[91mPayed with Amount: %d\033[0m\n", amount);
-                    } else {
-                        printf("No Ticket Generated.\n");
+                    PaymentSettlement settlement;
+                    if (settleAirlines(&airlineId, 1, &settlement)) {
+                        if (settlement.amount > 0) {
+                            printf("\033[91mPayed with Amount: %lld for %d tickets\033[0m\n",
+                                   (long long)settlement.amount, settlement.tickets);
+                        } else {
+                            printf("No Ticket Generated.\n");
+                        }
                     }
-                    close(fd3);
                 } else {
                     printf("No payment initiated.\n");
                 }
             }
-            else if (choice == 'g')
+            else if (choice == payAll)
+            {
+                int airlineIds[MAX_AIRLINES];
+                PaymentSettlement settlements[MAX_AIRLINES];
+                for (int a = 0; a < airlineCount; a++) airlineIds[a] = a;
+                if (settleAirlines(airlineIds, airlineCount, settlements)) {
+                    int64_t paid = 0;
+                    for (int a = 0; a < airlineCount; a++) {
+                        if (settlements[a].rejected) {
+                            printf("%s: rejected by the payment service\n", airlines[a].name);
+                        } else if (settlements[a].tickets > 0) {
+                            printf("%s: %d tickets, %lld\n", airlines[a].name, settlements[a].tickets,
+                                   (long long)settlements[a].amount);
+                        }
+                        paid += settlements[a].amount;
+                    }
+                    if (paid > 0) printf("\033[91mPayed with Amount: %lld\033[0m\n", (long long)paid);
+                    else printf("No Ticket Generated.\n");
+                }
+            }
+            else if (choice == allTickets)
             {
                   FILE *file;
                   char filename[] = "avn_report.log";  
@@ -1439,10 +6818,15 @@ int main() {
         }
     }
     sfmlRunning = false;
-    pthread_join(sfmlThreadId, NULL);
+    if (!headless) pthread_join(sfmlThreadId, NULL);
+    snapshotShutdown();
+    lookaheadShutdown();
     for (int i = 0; i < MAX_RUNWAYS; i++) {
         pthread_mutex_destroy(&runwayLocks[i]);
     }
     pthread_mutex_destroy(&flightDataMutex);
+    schedulerDestroy();
+    statsShutdown();
+    logShutdown();
     return 0;
 }
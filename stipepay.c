@@ -7,6 +7,15 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <stddef.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include "airlines.h"
 
 typedef enum { COMMERCIAL, CARGO, EMERGENCY, VIP } FlightType;
 
@@ -16,7 +25,10 @@ typedef struct {
     int amount;
     FlightType airlinetype;
     int airlineId;
-    char airlineName[30];
+    uint64_t traceId;
+    uint64_t detectedNs;
+    uint64_t issuedNs;
+    uint64_t ledgerNs;
 } TicketData;
 
 typedef struct {
@@ -25,23 +37,245 @@ typedef struct {
 } SharedTicketInfo;
 
 const char* avn_fifo = "AVNtoSP";
-const char* atc_to_sp_fifo = "ATCtoSP";
-const char* sp_to_atc_fifo = "SPtoATC";
+
+// ATC payment requests arrive over a SOCK_SEQPACKET socket, one connection
+// per ATC. A client may send any number of requests without waiting; each
+// carries an id the client picked and every response message echoes it, so
+// answers never cross between requests or between clients. A settlement is
+// answered with zero or more PAYMENT_SETTLED messages listing the ticket ids
+// it paid, then one PAYMENT_TOTAL. q1.c mirrors these records.
+#define SP_SOCKET_PATH "ATCtoSP.sock"
+#define MAX_PAYMENT_CLIENTS 16
+#define PAYMENT_IDS_PER_MESSAGE 64
+#define PAYMENT_SEND_TIMEOUT_MS 1000
+
+typedef enum { PAYMENT_SETTLE = 1 } PaymentRequestType;
+typedef enum { PAYMENT_SETTLED = 1, PAYMENT_TOTAL, PAYMENT_REJECTED } PaymentResponseType;
+
+typedef struct {
+    uint32_t requestId;
+    uint32_t type;
+    int32_t airlineId;
+} PaymentRequest;
+
+// Only the first count ticket ids are sent.
+typedef struct {
+    uint32_t requestId;
+    uint32_t type;
+    int32_t airlineId;
+    int32_t count;       // ids below (SETTLED) or tickets settled (TOTAL)
+    int64_t amount;      // sum over the ids below, or the request's total
+    int32_t ticketIds[PAYMENT_IDS_PER_MESSAGE];
+} PaymentResponse;
+
+const char* sp_socket_path = SP_SOCKET_PATH;
 
 void cleanup_fifos(int signo) {
     unlink(avn_fifo);
-    unlink(atc_to_sp_fifo);
-    unlink(sp_to_atc_fifo);
+    unlink(sp_socket_path);
     printf("\nFIFOs cleaned up. Exiting.\n");
     exit(0);
 }
 
+const char* trace_log = "avn_trace.log";
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// One line per ticket: trace id, then the detection, issuance and ledger
+// timestamps. tracecol reads this file to report per-stage latency.
+void recordTicketTrace(const TicketData* t) {
+    if (t->traceId == 0) return;
+    FILE* traceFile = fopen(trace_log, "a");
+    if (!traceFile) {
+        perror("Failed to open trace log");
+        return;
+    }
+    fprintf(traceFile, "%016llx %llu %llu %llu %d %d\n", (unsigned long long)t->traceId,
+            (unsigned long long)t->detectedNs, (unsigned long long)t->issuedNs,
+            (unsigned long long)t->ledgerNs, t->id, t->airlineId);
+    fclose(traceFile);
+}
+
+// Every ticket received from AVN, in arrival order. Unpaid tickets are also
+// chained per airline, so a settlement walks only the tickets it pays.
 typedef struct {
-TicketData ticket[200];
-int count;
+    TicketData* ticket;
+    int* nextUnpaid;              // next unpaid ticket of the same airline, -1 at the end
+    int count;
+    int capacity;
+    int unpaidHead[MAX_AIRLINES];
+    int unpaidTail[MAX_AIRLINES];
 } TotalData;
 
-int main() {
+void initLedger(TotalData* total) {
+    memset(total, 0, sizeof(*total));
+    for (int a = 0; a < MAX_AIRLINES; a++) total->unpaidHead[a] = total->unpaidTail[a] = -1;
+}
+
+void addTicket(TotalData* total, const TicketData* td) {
+    if (total->count == total->capacity) {
+        int capacity = total->capacity ? total->capacity * 2 : 256;
+        TicketData* ticket = realloc(total->ticket, sizeof(TicketData) * capacity);
+        int* nextUnpaid = realloc(total->nextUnpaid, sizeof(int) * capacity);
+        if (!ticket || !nextUnpaid) {
+            perror("Failed to grow ticket ledger");
+            exit(EXIT_FAILURE);
+        }
+        total->ticket = ticket;
+        total->nextUnpaid = nextUnpaid;
+        total->capacity = capacity;
+    }
+    int i = total->count++;
+    total->ticket[i] = *td;
+    total->nextUnpaid[i] = -1;
+    int a = td->airlineId;
+    if (td->status != 0 || a < 0 || a >= MAX_AIRLINES) return;
+    if (total->unpaidTail[a] >= 0) total->nextUnpaid[total->unpaidTail[a]] = i;
+    else total->unpaidHead[a] = i;
+    total->unpaidTail[a] = i;
+}
+
+typedef struct {
+    int fd;
+    long requests;
+} PaymentClient;
+
+PaymentClient paymentClients[MAX_PAYMENT_CLIENTS];
+int paymentClientCount = 0;
+
+int openPaymentSocket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("socket failed");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, MAX_PAYMENT_CLIENTS) < 0) {
+        perror("bind failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// A client that stops reading its answers is dropped after the send
+// timeout instead of stalling every other client behind it.
+void addPaymentClient(int fd) {
+    if (paymentClientCount == MAX_PAYMENT_CLIENTS) {
+        fprintf(stderr, "[SP] Too many ATC clients, refusing connection\n");
+        close(fd);
+        return;
+    }
+    struct timeval timeout = { PAYMENT_SEND_TIMEOUT_MS / 1000, (PAYMENT_SEND_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    paymentClients[paymentClientCount++] = (PaymentClient){ fd, 0 };
+}
+
+void dropPaymentClient(int c) {
+    printf("[SP] ATC client closed after %ld requests\n", paymentClients[c].requests);
+    close(paymentClients[c].fd);
+    paymentClients[c] = paymentClients[--paymentClientCount];
+}
+
+bool sendPaymentResponse(int fd, PaymentResponse* response) {
+    size_t size = offsetof(PaymentResponse, ticketIds);
+    if (response->type == PAYMENT_SETTLED) size += sizeof(int32_t) * response->count;
+    return send(fd, response, size, MSG_NOSIGNAL) == (ssize_t)size;
+}
+
+// Pays every unpaid ticket of the request's airline and streams the ids back.
+// Nothing is marked paid until the whole answer, total included, has been
+// handed to the client's socket: a client that times out or disconnects
+// midway leaves every ticket unpaid for its next request.
+bool settleAirline(TotalData* total, int fd, const PaymentRequest* request, FILE* logFile) {
+    int airlineId = request->airlineId;
+    PaymentResponse response = { request->requestId, PAYMENT_SETTLED, airlineId, 0, 0, {0} };
+    if (request->type != PAYMENT_SETTLE || airlineId < 0 || airlineId >= MAX_AIRLINES) {
+        response.type = PAYMENT_REJECTED;
+        return sendPaymentResponse(fd, &response);
+    }
+    char Name[AIRLINE_NAME_SIZE];
+    getAirlineName(airlineId, Name, sizeof(Name));
+    printf("[SP] Received request %u from ATC: %s\n", request->requestId, Name);
+    int settled = 0;
+    int64_t amount = 0;
+    bool sent = true;
+    for (int i = total->unpaidHead[airlineId]; i >= 0 && sent; i = total->nextUnpaid[i]) {
+        const TicketData* t = &total->ticket[i];
+        if (t->status != 0) continue;
+        response.ticketIds[response.count++] = t->id;
+        response.amount += t->amount;
+        if (response.count == PAYMENT_IDS_PER_MESSAGE) {
+            sent = sendPaymentResponse(fd, &response);
+            settled += response.count;
+            amount += response.amount;
+            response.count = 0;
+            response.amount = 0;
+        }
+    }
+    if (sent && response.count > 0) {
+        sent = sendPaymentResponse(fd, &response);
+        settled += response.count;
+        amount += response.amount;
+    }
+    if (sent) {
+        response.type = PAYMENT_TOTAL;
+        response.count = settled;
+        response.amount = amount;
+        sent = sendPaymentResponse(fd, &response);
+    }
+    if (!sent) {
+        printf("[SP] Request %u for %s aborted; its tickets stay unpaid\n", request->requestId, Name);
+        return false;
+    }
+    printf("Following are the Details of the tickets Unpaid --> \n");
+    for (int i = total->unpaidHead[airlineId]; i >= 0; i = total->unpaidHead[airlineId]) {
+        TicketData* t = &total->ticket[i];
+        total->unpaidHead[airlineId] = total->nextUnpaid[i];
+        if (t->status != 0) continue;
+        printf("\033[34m[SP] Ticket Received:\n TicketID: %d\nStatus: Paid\n  Amount: %d\n  Airline Type: %d\n  Airline ID: %d\n  Airline Name: \033[31m%s\033[34m\n\033[0m",
+               t->id, t->amount, t->airlinetype, t->airlineId, Name);
+        if (logFile) {
+            fprintf(logFile, "\033[34m[SP] Ticket Received:\n TicketID: %d\nStatus: Paid\n  Amount: %d\n  Airline Type: %d\n  Airline ID: %d\n  Airline Name: \033[31m%s\033[34m\n\033[0m",
+                    t->id, t->amount, t->airlinetype, t->airlineId, Name);
+        }
+        t->status = 1;
+    }
+    total->unpaidTail[airlineId] = -1;
+    if (logFile) fprintf(logFile, "\n");
+    printf("[SP] Settled %d tickets for %s: $%lld\n", settled, Name, (long long)amount);
+    return true;
+}
+
+// Answers every request the client has queued, in the order sent.
+bool serveClient(TotalData* total, PaymentClient* client) {
+    FILE* logFile = fopen("avn_report.log", "a");
+    if (!logFile) perror("Failed to open log file");
+    bool ok = true;
+    while (ok) {
+        PaymentRequest request;
+        ssize_t n = recv(client->fd, &request, sizeof(request), MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n == 0 || (n < 0 && errno != EINTR)) {
+            ok = false;
+        } else if (n == sizeof(request)) {
+            client->requests++;
+            ok = settleAirline(total, client->fd, &request, logFile);
+        }
+    }
+    if (logFile) fclose(logFile);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
     /*signal(SIGINT, cleanup_fifos);
 
     // Remove old FIFOs if they exist
@@ -163,106 +397,77 @@ int main() {
 
     return 0;
     */
-    // Create FIFOs
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            sp_socket_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--socket PATH]\n", argv[0]);
+            return 1;
+        }
+    }
     if (mkfifo(avn_fifo, 0666) == -1 && errno != EEXIST) {
         perror("Failed to create AVNtoSP FIFO");
         exit(1);
     }
-    if (mkfifo(atc_to_sp_fifo, 0666) == -1 && errno != EEXIST) {
-        perror("Failed to create ATCtoSP FIFO");
-        exit(1);
-    }
-    if (mkfifo(sp_to_atc_fifo, 0666) == -1 && errno != EEXIST) {
-        perror("Failed to create SPtoATC FIFO");
+    // Holding a write end keeps the FIFO from reporting EOF between AVN
+    // writers, so poll() never spins on a hung-up pipe.
+    int fd_avn = open(avn_fifo, O_RDONLY | O_NONBLOCK);
+    int keepalive = open(avn_fifo, O_WRONLY);
+    if (fd_avn < 0 || keepalive < 0) {
+        perror("Failed to open AVNtoSP FIFO");
         exit(1);
     }
+    int listenFd = openPaymentSocket(sp_socket_path);
+    if (listenFd < 0) exit(1);
     TotalData total;
-    total.count = 0;
-    TicketData latest_td = {0};
-    int fd_avn, fd_atc;
-    fd_set read_fds;
-    int max_fd;
+    initLedger(&total);
 
+    struct pollfd fds[MAX_PAYMENT_CLIENTS + 2];
     while (1) {
-        // Open AVN and ATC FIFOs non-blocking
-        fd_avn = open(avn_fifo, O_RDONLY | O_NONBLOCK);
-        fd_atc = open(atc_to_sp_fifo, O_RDONLY | O_NONBLOCK);
-        if (fd_avn < 0 || fd_atc < 0) {
-            perror("Failed to open one or more FIFOs");
-            sleep(1);
-            continue;
-        }
-
-        FD_ZERO(&read_fds);
-        FD_SET(fd_avn, &read_fds);
-        FD_SET(fd_atc, &read_fds);
-        max_fd = (fd_avn > fd_atc) ? fd_avn : fd_atc;
-
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, NULL);
-        if (activity < 0) {
-            perror("select() error");
+        int nfds = 0;
+        fds[nfds++] = (struct pollfd){ .fd = fd_avn, .events = POLLIN };
+        fds[nfds++] = (struct pollfd){ .fd = listenFd, .events = POLLIN };
+        for (int c = 0; c < paymentClientCount; c++)
+            fds[nfds++] = (struct pollfd){ .fd = paymentClients[c].fd, .events = POLLIN };
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno != EINTR) perror("poll error");
             continue;
         }
 
         // Handle AVN → SP
-        if (FD_ISSET(fd_avn, &read_fds)) {
-            ssize_t r = read(fd_avn, &latest_td, sizeof(TicketData));
-            if (r > 0) {
-                printf("[SP] Received booking from AVN: %s\n", latest_td.airlineName);
-                total.ticket[total.count++] = latest_td;
+        if (fds[0].revents) {
+            TicketData batch[64];
+            ssize_t r;
+            while ((r = read(fd_avn, batch, sizeof(batch))) > 0) {
+                for (int i = 0; i < (int)(r / sizeof(TicketData)); i++) {
+                    char name[AIRLINE_NAME_SIZE];
+                    printf("[SP] Received booking from AVN: %s\n",
+                           getAirlineName(batch[i].airlineId, name, sizeof(name)));
+                    batch[i].ledgerNs = monotonicNs();
+                    addTicket(&total, &batch[i]);
+                    recordTicketTrace(&batch[i]);
+                }
             }
         }
 
-        // Handle ATC → SP (request)
-        if (FD_ISSET(fd_atc, &read_fds)) {
-            char Name[30];
-            ssize_t r = read(fd_atc, Name, sizeof(Name));
-            if (r > 0) {
-                Name[r] = '\0';
-                int amount = 0;
-                    FILE* logFile = fopen("avn_report.log", "a");
-                    if (!logFile) 
-                    {
-                        perror("Failed to open log file");
-                        exit(EXIT_FAILURE);
-                    }
-                printf("[SP] Received request from ATC: %s\n", Name);
-                printf("Following are the Details of the tickets Unpaid --> \n");
-                for(int i=0;i<total.count;i++)
-                { 
-                      if (strcmp(total.ticket[i].airlineName, Name) == 0 && total.ticket[i].status == 0) 
-                      {
-                              printf("\033[34m[SP] Ticket Received:\n TicketID: %d\nStatus: Paid\n  Amount: %d\n  Airline Type: %d\n  Airline ID: %d\n  Airline Name: \033[31m%s\033[34m\n\033[0m",total.ticket[i].id
-               , total.ticket[i].amount, total.ticket[i].airlinetype, total.ticket[i].airlineId, total.ticket[i].airlineName);
-                              fprintf(logFile, "\033[34m[SP] Ticket Received:\n TicketID: %d\nStatus: Paid\n  Amount: %d\n  Airline Type: %d\n  Airline ID: %d\n  Airline Name: \033[31m%s\033[34m\n\033[0m",total.ticket[i].id, total.ticket[i].amount, total.ticket[i].airlinetype, total.ticket[i].airlineId, total.ticket[i].airlineName);
-                      }
-                }
-                fprintf(logFile, "\n");
-                fclose(logFile);
-                int fd_resp = open(sp_to_atc_fifo, O_WRONLY);
-                if (fd_resp >= 0) {
-                    
-                    for(int i=0;i<total.count;i++)
-                    {
-                        if (strcmp(total.ticket[i].airlineName, Name) == 0 && total.ticket[i].status == 0) 
-                        {
-                            amount += total.ticket[i].amount;
-                            total.ticket[i].status = 1;
-                        }
-                    }
-                    write(fd_resp, &amount, sizeof(int));
-                    close(fd_resp);
-                    printf("[SP] Sent booking to ATC: %s\n", latest_td.airlineName);
-                } else {
-                    perror("Failed to open SPtoATC FIFO");
-                }
-            }
+        if (fds[1].revents) {
+            int conn = accept(listenFd, NULL, NULL);
+            if (conn >= 0) addPaymentClient(conn);
         }
 
-        close(fd_avn);
-        close(fd_atc);
+        // Handle ATC → SP (requests). Walking down keeps the slots still to
+        // visit in place when a dropped client's slot is refilled.
+        int listed = nfds - 2;
+        for (int k = listed - 1; k >= 0; k--) {
+            if (!fds[k + 2].revents) continue;
+            if (!serveClient(&total, &paymentClients[k])) dropPaymentClient(k);
+        }
     }
 
+    close(fd_avn);
+    close(keepalive);
+    close(listenFd);
+    unlink(sp_socket_path);
     return 0;
     
 }
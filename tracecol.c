@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Reads the trace lines stipepay appends to avn_trace.log and reports how
+// long violations take to travel q1 -> avn -> stipepay, per stage and total.
+
+typedef struct {
+    const char* name;
+    uint64_t* values;
+    int count;
+} Stage;
+
+int compareValues(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+uint64_t percentile(const uint64_t* sorted, int count, double p) {
+    if (count == 0) return 0;
+    int index = (int)(p / 100.0 * count + 0.999999) - 1;
+    if (index < 0) index = 0;
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+void printStage(Stage* s) {
+    if (s->count == 0) {
+        printf("%-16s %8d\n", s->name, 0);
+        return;
+    }
+    qsort(s->values, s->count, sizeof(uint64_t), compareValues);
+    double sum = 0;
+    for (int i = 0; i < s->count; i++) sum += s->values[i];
+    printf("%-16s %8d %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n", s->name, s->count,
+           sum / s->count / 1e6, s->values[0] / 1e6,
+           percentile(s->values, s->count, 50) / 1e6, percentile(s->values, s->count, 90) / 1e6,
+           percentile(s->values, s->count, 99) / 1e6, s->values[s->count - 1] / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : "avn_trace.log";
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror("Failed to open trace log");
+        return 1;
+    }
+    int capacity = 1024;
+    Stage stages[3] = {
+        {"detect->issue", NULL, 0},
+        {"issue->ledger", NULL, 0},
+        {"detect->ledger", NULL, 0}
+    };
+    for (int i = 0; i < 3; i++) {
+        stages[i].values = malloc(sizeof(uint64_t) * capacity);
+        if (!stages[i].values) {
+            perror("malloc failed");
+            return 1;
+        }
+    }
+    unsigned long long traceId, detected, issued, ledger;
+    int avnId, airlineId;
+    int skipped = 0;
+    while (fscanf(file, "%llx %llu %llu %llu %d %d", &traceId, &detected, &issued, &ledger,
+                  &avnId, &airlineId) == 6) {
+        if (detected == 0 || issued < detected || ledger < issued) {
+            skipped++;
+            continue;
+        }
+        if (stages[0].count == capacity) {
+            capacity *= 2;
+            for (int i = 0; i < 3; i++) {
+                uint64_t* grown = realloc(stages[i].values, sizeof(uint64_t) * capacity);
+                if (!grown) {
+                    perror("realloc failed");
+                    return 1;
+                }
+                stages[i].values = grown;
+            }
+        }
+        stages[0].values[stages[0].count++] = issued - detected;
+        stages[1].values[stages[1].count++] = ledger - issued;
+        stages[2].values[stages[2].count++] = ledger - detected;
+    }
+    fclose(file);
+
+    printf("Violation-to-ticket latency (milliseconds) from %s\n", path);
+    printf("%-16s %8s %12s %12s %12s %12s %12s %12s\n",
+           "stage", "count", "mean", "min", "p50", "p90", "p99", "max");
+    for (int i = 0; i < 3; i++) {
+        printStage(&stages[i]);
+        free(stages[i].values);
+    }
+    if (skipped > 0) printf("Skipped %d incomplete or out-of-order traces\n", skipped);
+    return 0;
+}